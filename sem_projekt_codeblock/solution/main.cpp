@@ -18,119 +18,762 @@
 #include <iomanip>      // std::setprecision
 #include <stdexcept>	// exception handling mechanism (try - catch block)
 #include <list>
+#include <bitset>		// bitmapa obsazenych ID
+#include <unordered_map>
+#include <unordered_set>	// ID podle souboru nad MAX_ID
+#include <string_view>	// std::string_view - pole radku bez kopirovani
+#include <cstring>		// memchr
+#include <climits>		// INT_MAX, INT_MIN
+#include <cstdint>		// int64_t
+#include <charconv>		// std::to_chars
+#include <cstdio>		// FILE, fwrite, rename
+#include <thread>		// std::thread - paralelni nacitani
+#include <atomic>		// std::atomic
+#include <map>			// std::map - behy mesicu streamovaneho vystupu
+#include <mutex>		// std::mutex - journal pridanych zaznamu
+#include <condition_variable>
+#include <chrono>		// std::chrono::milliseconds
+#include <functional>	// std::ref
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>	// CreateFileMapping, MapViewOfFile
+#else
+#include <sys/mman.h>	// mmap
+#include <sys/stat.h>	// fstat
+#include <fcntl.h>		// open
+#include <unistd.h>		// close
+#include <dirent.h>		// opendir, readdir - vyber vstupnich souboru maskou
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CSV_SIMD			// vektorove hledani oddelovacu (SSE2, AVX2 podle procesoru)
+#include <immintrin.h>	// _mm_cmpeq_epi8, _mm256_cmpeq_epi8
+#endif
 
 
 #define DELIMITER ','	/*!< csv delimiter setup */
+#define MAX_ID 9999		/*!< nejvetsi povolene ID zaznamu */
+#define MAX_CASTKA 99999999999999LL	/*!< nejvetsi povolena castka v halerich (999,999,999,999.99 Kc) */
+#define HTML_BUFFER_SIZE (1 << 20)	/*!< velikost bufferu html vystupu, pri jejim prekroceni se na konci sekce zapisuje na disk */
+#define PARALLEL_MIN_SIZE (4 << 20)	/*!< mensi soubory se nacitaji jednim vlaknem, vlakna by se nevyplatila */
+#define CHUNKS_PER_THREAD 4			/*!< na kolik casti na jedno vlakno se soubor rozdeli pri paralelnim nacitani */
+#define STREAM_MEMORY_BUDGET (64 << 20)	/*!< kolik bajtu zaznamu muze streamovany html vystup drzet v pameti, pak je zapise do behu na disk */
+#define SNAPSHOT_VERSION 3			/*!< verze formatu snapshotu, zvysit pri kazde zmene UcetniData nebo kontrol vstupu */
+#define JOURNAL_GROUP_COMMIT_MS 10	/*!< jak dlouho journal po prvnim zaznamu ceka na dalsi, aby je zapsal jednim fsync */
+#define DATE_CACHE_SIZE 256			/*!< pocet polozek cache prevedenych datumu na vlakno (mocnina 2) */
+#define BALANCE_EPOCH_YEAR 1582		/*!< den 1 indexu zustatku je 1. 1. tohoto roku (nejmensi platny rok) */
+#define MAX_INPUT_FILES 1000		/*!< nejvic vstupnich souboru slucovanych do jedne knihy, ID podle souboru se musi vejit do int32_t */
 
 using namespace std;
 
+/** @enum TypZaznamu
+ *  @brief Typ zaznamu, prijem nebo vydaj.
+ */
+enum TypZaznamu : uint8_t
+{
+	TYP_NEPLATNY,	/**< neplatny typ, vypisuje se jako "x" */
+	TYP_PRIJEM,		/**< prijem */
+	TYP_VYDAJ		/**< vydaj */
+};
+
 /**
  * @brief struktura ucetnich dat, zde se ukladaji jednotlive polozky
+ *
+ * Zaznam je zabaleny do 24 bajtu bez alokaci na heapu: datum je jedno cislo RRRRMMDD, typ je enum
+ * a kategorie je ID do slovniku kategorii. Textovou podobu vraci DateText, TypeText a CategoryText.
  */
 struct UcetniData
 {
-	int ID;                 /**< Unikatni ID zaznamu. */
-	string prijemVydaj;		/**< Prijem, nebo vydaj. */
-	string kategorie;       /**< Kategorie zaznamu. */
-	double castka;			/**< Maximalni castka 999,999,999 Kc. */
-	string day;             /**< Den zaznamu. */
-	string month;           /**< Mesic zaznamu. */
-	string year;            /**< Rok zaznamu. */
-	//string datum;			// korektni format casu DD/MM/YYYY
+	int64_t castka;			/**< Castka v halerich, maximalni castka 999,999,999,999.99 Kc. */
+	int32_t ID;				/**< Unikatni ID zaznamu. */
+	uint32_t datum;			/**< Datum zaznamu jako RRRRMMDD, 0 pokud je datum neplatne. */
+	uint32_t kategorie;		/**< ID kategorie zaznamu ve slovniku kategorii. */
+	TypZaznamu prijemVydaj;	/**< Prijem, nebo vydaj. */
+	bool castkaPlatna;		/**< Jestli je castka platna (cislo v povolenem rozsahu). */
+};
+
+/** @struct CategoryDictionary
+ *  @brief Slovnik kategorii, kazda ruzna normalizovana kategorie ma sve huste ID 0, 1, 2, ...
+ *
+ *  Kategorie se porovnavaji bez okrajovych mezer a bez ohledu na velikost pismen ("Koupe " je "koupe"),
+ *  soucty po kategoriich se pak pocitaji do pole indexovaneho ID kategorie.
+ *  @param CategoryDictionary.names   Nazvy kategorii podle ID
+ *  @param CategoryDictionary.ids   Prevod normalizovaneho nazvu kategorie na ID
+ */
+struct CategoryDictionary
+{
+	vector<string> names;					/*!< nazev kategorie tak, jak byl poprve nacten (bez okrajovych mezer) */
+	unordered_map<string, uint32_t> ids;	/*!< normalizovany nazev (mala pismena, bez okrajovych mezer) -> ID */
+};
+
+/** @struct CategoryTotal
+ *  @brief Soucet castek jedne kategorie v jednom mesici.
+ */
+struct CategoryTotal
+{
+	uint32_t kategorie;		/*!< ID kategorie */
+	int64_t castka;			/*!< soucet castek v halerich */
+};
+
+/** @struct MonthTotals
+ *  @brief Souhrn jednoho mesice html vystupu, zaznamy a kategorie jsou rozsahy v serazenych datech a v ReportTotals.kategorie.
+ */
+struct MonthTotals
+{
+	int rok;					/*!< rok */
+	int mesic;					/*!< mesic 1 - 12 */
+	size_t prvniZaznam;			/*!< index prvniho zaznamu mesice v serazenych datech */
+	size_t pocetZaznamu;		/*!< pocet zaznamu mesice */
+	size_t prvniKategorie;		/*!< index prvni kategorie mesice v ReportTotals.kategorie */
+	size_t pocetKategorii;		/*!< pocet kategorii mesice */
+	int64_t prijem;				/*!< soucet prijmu v halerich */
+	int64_t vydaj;				/*!< soucet vydaju v halerich */
+};
+
+/** @struct YearTotals
+ *  @brief Souhrn jednoho roku html vystupu, mesice jsou rozsah v ReportTotals.mesice.
+ */
+struct YearTotals
+{
+	int rok;					/*!< rok */
+	size_t prvniMesic;			/*!< index prvniho mesice roku v ReportTotals.mesice */
+	size_t pocetMesicu;			/*!< pocet mesicu roku */
+	int64_t prijem;				/*!< soucet prijmu v halerich */
+	int64_t vydaj;				/*!< soucet vydaju v halerich */
+	int64_t zustatek;			/*!< zustatek ke konci roku (prijmy - vydaje tohoto a vsech starsich roku) */
+};
+
+/** @struct ReportTotals
+ *  @brief Predpocitane soucty pro html vystup, vytvori je AggregateReport jednim pruchodem serazenych dat.
+ *  @param ReportTotals.roky   Roky od nejnovejsiho
+ *  @param ReportTotals.mesice   Mesice od nejnovejsiho
+ *  @param ReportTotals.kategorie   Soucty kategorii vsech mesicu za sebou
+ */
+struct ReportTotals
+{
+	vector<YearTotals> roky;				/*!< roky */
+	vector<MonthTotals> mesice;				/*!< mesice vsech roku */
+	vector<CategoryTotal> kategorie;		/*!< kategorie vsech mesicu */
+};
+
+/** @struct QueryIndex
+ *  @brief Index nactenych zaznamu pro dotazy (RunQuery), doplnuje se o nove zaznamy pri dalsim dotazu.
+ */
+struct QueryIndex
+{
+	size_t records = 0;						/*!< pocet zaindexovanych zaznamu (prvnich records zaznamu dat) */
+	vector<uint64_t> byDate;				/*!< datum << 32 | index zaznamu, vzestupne, jen zaznamy s platnym datem */
+	vector<vector<uint32_t>> byCategory;	/*!< pro kazde ID kategorie vzestupne indexy jejich zaznamu */
+	vector<uint32_t> byType[3];				/*!< pro kazdy TypZaznamu vzestupne indexy jeho zaznamu */
+};
+
+/** @struct BalanceIndex
+ *  @brief Index zustatku platnych zaznamu (IsReportable) po dnech, Fenwickuv strom pro soucty v O(log n).
+ *
+ *  Strom je nad cisly dnu od 1. 1. BALANCE_EPOCH_YEAR (DayNumber), takze kazdy zaznam je jedno pricteni
+ *  ke svemu dni. Velikost je mocnina 2 a zdvojnasobuje se podle nejpozdejsiho dne (BalanceReserve).
+ */
+struct BalanceIndex
+{
+	size_t records = 0;			/*!< pocet zapocitanych zaznamu (prvnich records zaznamu dat) */
+	vector<int64_t> tree;		/*!< Fenwickuv strom prijmu - vydaju po dnech, tree[i] je soucet dnu (i - (i & -i), i] (od 1) */
+};
+
+/** @struct Query
+ *  @brief Dotaz nad nactenymi daty, zaznam musi splnit vsechny zadane podminky.
+ */
+struct Query
+{
+	uint32_t od = 0;				/*!< datum od RRRRMMDD vcetne, 0 - bez omezeni */
+	uint32_t doDatum = UINT32_MAX;	/*!< datum do RRRRMMDD vcetne, UINT32_MAX - bez omezeni */
+	int typ = -1;					/*!< TypZaznamu, -1 - vse */
+	int64_t kategorie = -1;			/*!< ID kategorie, -1 - vse */
+};
+
+/** @struct MonthRun
+ *  @brief Zaznamy jednoho mesice streamovaneho html vystupu.
+ *
+ *  Zaznamy se drzi v pameti, dokud se vsechny mesice dohromady vejdou do STREAM_MEMORY_BUDGET,
+ *  potom se pripisou na konec behu mesice na disku. Poradi zaznamu v behu je poradi souboru.
+ */
+struct MonthRun
+{
+	vector<UcetniData> buffer;	/*!< zaznamy, ktere jeste nejsou na disku */
+	size_t spilled = 0;			/*!< pocet zaznamu v behu na disku */
+	string path;				/*!< soubor behu na disku */
+};
+
+/** @struct MonthFragment
+ *  @brief Vyrenderovany mesic html vystupu v cache, znovu se renderuje jen pri zmene otisku jeho zaznamu.
+ */
+struct MonthFragment
+{
+	uint64_t fingerprint = 0;	/*!< otisk platnych zaznamu mesice v poradi souboru (RecordHash) */
+	size_t pocetZaznamu = 0;	/*!< pocet platnych zaznamu mesice */
+	bool dirty = false;			/*!< mesic se musi vyrenderovat znovu */
+	int64_t prijem = 0;			/*!< soucet prijmu v halerich */
+	int64_t vydaj = 0;			/*!< soucet vydaju v halerich */
+	string html;				/*!< vyrenderovany mesic (HtmlMonth) */
+};
+
+/** @struct HtmlCache
+ *  @brief Cache vyrenderovanych mesicu pro CreateHtml.
+ *  @param HtmlCache.settings   Nastaveni zobrazeni, pro ktere fragmenty plati
+ *  @param HtmlCache.months   Fragmenty podle indexu mesice (rok * 12 + mesic - 1)
+ */
+struct HtmlCache
+{
+	string settings;						/*!< oddelovace a halere, se kterymi se fragmenty renderovaly */
+	map<uint32_t, MonthFragment> months;	/*!< fragmenty mesicu */
+};
+
+/** @struct MoneyBuffer
+ *  @brief Buffer na zasobniku pro naformatovanou castku, SpacedMoneyValue do nej pise zprava doleva.
+ */
+struct MoneyBuffer
+{
+	char text[32];		/*!< nejdelsi castka "-92,233,720,368,547,758.07" + '\0' se vejde */
+};
+
+/** @struct HtmlWriter
+ *  @brief Zapis html souboru pres buffer v pameti.
+ *
+ *  Na disk se zapisuje jen na hranici sekci (rok), kdyz buffer prekroci HTML_BUFFER_SIZE, a na konci.
+ *  Zapisuje se do docasneho souboru, ktery se az po dokonceni prejmenuje na cilovy soubor,
+ *  takze nikdo nikdy neuvidi napul zapsany html soubor.
+ */
+struct HtmlWriter
+{
+	FILE *file = nullptr;	/*!< otevreny docasny soubor */
+	string path;			/*!< cilovy soubor */
+	string tmpPath;			/*!< docasny soubor, do ktereho se zapisuje */
+	string buffer;			/*!< data, ktera jeste nejsou zapsana na disk */
+	bool failed = false;	/*!< nastala chyba pri zapisu */
+};
+
+/* gregoriánský kalendář, který má přestupný každý čtvrtý rok (rok dělitelný beze zbytku
+   čtyřmi), ale roky dělitelné 100 jsou přestupné jenom tehdy, jsou-li dělitelné také 400.
+*/
+constexpr bool IsLeapYear(int year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+constexpr uint8_t DAYS_IN_MONTH[2][13] =
+{
+	{ 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },		/**< normalni rok, index je mesic 1 - 12 */
+	{ 0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 }		/**< prestupny rok */
+};
+
+static_assert(!IsLeapYear(1900) && IsLeapYear(2000) && IsLeapYear(2020) && !IsLeapYear(2100), "gregoriansky kalendar");
+
+/** @enum DateChar
+ *  @brief Druh znaku v poli datumu (DATE_CHARS).
+ */
+enum DateChar : uint8_t
+{
+	DATE_CHAR_OTHER,		/**< jiny znak */
+	DATE_CHAR_DIGIT,		/**< cislice 0 - 9 */
+	DATE_CHAR_DELIMITER		/**< oddelovac dne, mesice a roku: ' ', '.', '-', ':' */
+};
+
+/** @struct DateCharTable
+ *  @brief Tabulka druhu znaku pro ParseDate, sestavi se pri prekladu.
+ */
+struct DateCharTable
+{
+	DateChar type[256];		/*!< druh znaku podle jeho hodnoty */
+
+	constexpr DateCharTable() : type()
+	{
+		for (int c = '0'; c <= '9'; c++)
+			type[c] = DATE_CHAR_DIGIT;
+		type[(unsigned char)' '] = type[(unsigned char)'.'] = type[(unsigned char)'-'] = type[(unsigned char)':'] = DATE_CHAR_DELIMITER;
+	}
 };
 
+constexpr DateCharTable DATE_CHARS;
+
 /** @struct Months
  *  @brief Struktura obsahujici pocet dnu v danem mesici.
- *  @param Months.daysOfMonth   Pocet dnu mesice
  *  @param Months.nazvyMesicu   Nazev mesice
  */
 struct Months
 {
-	int daysOfMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };	/**<  Unor 28 - 29 dni v zavyslosti na prestupnem roku */
 	string nazvyMesicu[12] = { "Leden", "Unor", "Brezen", "Duben", "Kveten", "Cerven", "Cervenec", "Srpen", "Zari", "Rijen", "Listopad", "Prosinec" }; /**<  nazvy mesicu */
 
 	public:
-		int NumOFDays(int month, int year)
+		int NumOFDays(int month, int year) const
 		{
-			if (month == 2)
-			{
-				if (year % 4 == 0 || year % 400 == 0)	// podminka prestupneho roku
-					return daysOfMonth[month-1] + 1;	/**<  return 29 */
-				else
-					return daysOfMonth[month-1];		/**< return 28 */
-			}
-			else
-				return daysOfMonth[month-1];            /**< return normalni pocet dnu v danem mesici */
-	}
-	// prestupny rok	 {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};						 -----
+			return DAYS_IN_MONTH[IsLeapYear(year)][month];
+		}
+};
+
+/** @enum ErrorCode
+ *  @brief Druh chyby zaznamu, text chyby vraci ErrorMessage az pri vypisu.
+ */
+enum ErrorCode : uint8_t
+{
+	ERROR_ID_TOO_BIG,			/**< ID je vetsi nez MAX_ID */
+	ERROR_ID_NEGATIVE,			/**< ID je zaporne */
+	ERROR_MONEY_NOT_NUMBER,		/**< castka neni cislo */
+	ERROR_MONEY_RANGE,			/**< castka je moc velka, nebo zaporna */
+	ERROR_DATE_LEAP_YEAR,		/**< 29. unor v neprestupnem roce */
+	ERROR_DATE_FORMAT,			/**< spatny format datumu */
+	ERROR_DATE_DAY,				/**< neplatny den */
+	ERROR_DATE_MONTH,			/**< neplatny mesic */
+	ERROR_DATE_MISSING,			/**< chybi datum */
+	ERROR_CODE_COUNT			/**< pocet druhu chyb */
+};
+
+/** @struct ErrorEntry
+ *  @brief Jedna chyba zaznamu.
+ */
+struct ErrorEntry
+{
+	int32_t id;			/*!< id ve kterem je chyba */
+	uint32_t line;		/*!< radek souboru, u zaznamu z journalu radek journalu (0 - neznamy) */
+	ErrorCode code;		/*!< druh chyby */
+	uint16_t file;		/*!< poradi vstupniho souboru v inputFiles od 1, 0 - jediny vstupni soubor */
+};
+
+/** @struct ErrorLog
+ *  @brief Chyby zaznamu v poradi souboru a jejich pocty podle druhu.
+ */
+struct ErrorLog
+{
+	vector<ErrorEntry> entries;					/*!< chyby v poradi souboru */
+	uint64_t counts[ERROR_CODE_COUNT] = { 0 };	/*!< pocet chyb podle druhu */
+	uint32_t line = 0;							/*!< cislo radku, ke kteremu se pripisuji nove chyby, parsery ho zvysuji s kazdym radkem */
+	uint16_t file = 0;							/*!< vstupni soubor, ke kteremu se pripisuji nove chyby (ErrorEntry.file) */
+};
+
+/** @struct DateCacheEntry
+ *  @brief Polozka cache prevedenych datumu (ParseDate), stejne texty datumu se v souborech opakuji.
+ */
+struct DateCacheEntry
+{
+	char text[15];					/*!< text datumu */
+	uint8_t length = 0;				/*!< delka textu */
+	bool valid = false;				/*!< polozka obsahuje ulozeny datum */
+	uint32_t datum;					/*!< prevedene datum, 0 pokud je neplatne */
+	ErrorCode error;				/*!< chyba neplatneho datumu */
+};
+
+/** @enum NumberStatus
+ *  @brief Vysledek prevodu textu na cislo (ParseInt, ParseMoney).
+ */
+enum NumberStatus
+{
+	NUMBER_OK,				/**< cislo se podarilo prevest */
+	NUMBER_INVALID,			/**< text nezacina cislem */
+	NUMBER_OUT_OF_RANGE		/**< cislo se nevejde do ciloveho typu */
+};
+
+/** @enum StatsPhase
+ *  @brief Mereny usek programu pro statistiky (PhaseStats).
+ */
+enum StatsPhase
+{
+	PHASE_READ,				/**< namapovani a precteni vstupniho souboru */
+	PHASE_SNAPSHOT,			/**< nacteni snapshotu */
+	PHASE_TOKENIZE,			/**< rozdeleni na radky a pole */
+	PHASE_VALIDATE_ID,		/**< kontrola ID */
+	PHASE_VALIDATE_MONEY,	/**< kontrola castky */
+	PHASE_VALIDATE_DATE,	/**< kontrola datumu */
+	PHASE_SORT,				/**< razeni html vystupu */
+	PHASE_AGGREGATE,		/**< soucty html vystupu */
+	PHASE_HTML_RENDER,		/**< renderovani mesicu html vystupu */
+	PHASE_HTML_WRITE,		/**< zapis html na disk */
+	PHASE_COUNT				/**< pocet useku */
+};
+
+/** @enum StatsReject
+ *  @brief Duvod, proc se zaznam nevypise do html, pro statistiky odmitnutych radku.
+ */
+enum StatsReject
+{
+	REJECT_ID,				/**< neplatne, nebo duplicitni ID */
+	REJECT_TYPE,			/**< neplatny typ */
+	REJECT_CATEGORY,		/**< prazdna kategorie */
+	REJECT_MONEY,			/**< neplatna castka */
+	REJECT_DATE,			/**< neplatne datum */
+	REJECT_COUNT			/**< pocet duvodu */
+};
+
+/** @struct PhaseStats
+ *  @brief Cas a pocitadla jednoho useku, pricitaji se i z vlaken paralelniho nacitani (cas je soucet vsech vlaken).
+ */
+struct PhaseStats
+{
+	atomic<uint64_t> nanoseconds{0};	/*!< celkovy cas useku */
+	atomic<uint64_t> calls{0};			/*!< kolikrat se usek meril */
+	atomic<uint64_t> rows{0};			/*!< zpracovane radky / zaznamy */
+	atomic<uint64_t> bytes{0};			/*!< zpracovane bajty */
+};
+
+/** @struct PhaseTotals
+ *  @brief Lokalni soucty casu useku jednoho vlakna (bez atomickych operaci), do phaseStats se prictou najednou (StatsMerge).
+ */
+struct PhaseTotals
+{
+	uint64_t nanoseconds[PHASE_COUNT] = {};		/*!< celkovy cas useku */
+	uint64_t calls[PHASE_COUNT] = {};			/*!< kolikrat se usek meril */
+};
+
+/** @struct StatsTimer
+ *  @brief Meri cas od vytvoreni do zaniku a pricte ho k useku, nebo k lokalnim souctum. Pri vypnutych statistikach nedela nic.
+ */
+struct StatsTimer
+{
+	StatsPhase phase;								/*!< mereny usek */
+	bool active;									/*!< statistiky byly pri vytvoreni zapnute */
+	PhaseTotals *totals;							/*!< lokalni soucty, nullptr = primo do phaseStats */
+	chrono::steady_clock::time_point start;			/*!< zacatek mereni */
+
+	explicit StatsTimer(StatsPhase measured);
+	StatsTimer(StatsPhase measured, PhaseTotals &local);
+	~StatsTimer();
+};
+
+/** @struct MappedFile
+ *  @brief Vstupni soubor namapovany do pameti jen pro cteni.
+ *  @param MappedFile.data   Ukazatel na zacatek obsahu souboru
+ *  @param MappedFile.size   Velikost souboru v bajtech
+ */
+struct MappedFile
+{
+	const char *data = nullptr;		/*!< obsah souboru, nullptr u prazdneho souboru */
+	size_t size = 0;				/*!< velikost obsahu v bajtech */
+	int64_t mtime = 0;				/*!< cas posledni zmeny souboru */
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;	/*!< handle otevreneho souboru */
+	HANDLE mapping = nullptr;			/*!< handle mapovani souboru */
+#else
+	int fd = -1;					/*!< file descriptor otevreneho souboru */
+#endif
+};
 
-	/* gregoriánský kalendář, který má přestupný každý čtvrtý rok (rok dělitelný beze zbytku
-	   čtyřmi), ale roky dělitelné 100 jsou přestupné jenom tehdy, jsou-li dělitelné také 400.
-	*/
+/** @struct IdIndex
+ *  @brief Index obsazenych ID, drzi se vedle ucetnich dat a kontrola duplicity je v O(1).
+ *  @param IdIndex.used   Bitmapa obsazenych ID 0 - MAX_ID
+ *  @param IdIndex.invalidUsed   Jestli uz existuje zaznam s neplatnym ID -1
+ *  @param IdIndex.namespaced   Obsazena ID podle souboru nad MAX_ID (LoadLedgers)
+ */
+struct IdIndex
+{
+	bitset<MAX_ID + 1> used;	/*!< bit i je nastaven, pokud je ID i obsazeno */
+	bool invalidUsed = false;	/*!< zaznam s ID -1 (duplicitni, nebo neplatne ID) */
+	unordered_set<int32_t> namespaced;	/*!< ID podle souboru (NamespacedId) vetsi nez MAX_ID */
+};
+
+/** @struct LoadedFile
+ *  @brief Informace o nactene casti vstupniho souboru pro dalsi nacteni jen nove pripsanych radku.
+ *  @param LoadedFile.path   Cesta k nactenemu souboru, prazdna pokud nejde navazat
+ *  @param LoadedFile.offset   Pocet nactenych bajtu souboru
+ */
+struct LoadedFile
+{
+	string path;				/*!< nacteny soubor, prazdny pokud se musi nacist cely znovu */
+	size_t offset = 0;			/*!< pocet nactenych bajtu, vzdy konci za '\n' */
+	uint64_t prefixHash = 0;	/*!< hash nactenych bajtu (HashBuffer) */
+	size_t records = 0;			/*!< pocet zaznamu nactenych ze souboru */
+	uint32_t lines = 0;			/*!< pocet nactenych radku, od nej pokracuji cisla radku chyb */
+};
+
+/** @struct Journal
+ *  @brief Journal rucne pridanych zaznamu (soubor <cesta k csv>.journal) ve stejnem formatu jako .csv soubor.
+ *
+ *  AddData prida radek do pending a pocka, az ho vlakno committer zapise: vsechny radky, ktere se
+ *  nasbiraly behem JOURNAL_GROUP_COMMIT_MS nebo behem predchoziho fsync, zapise najednou a potvrdi
+ *  jednim fsync (group commit). Radky se cisluji, AddData se vrati, az je davka s jeho radkem na disku.
+ *  Pri nacteni .csv souboru se journal prehraje za jeho data.
+ */
+struct Journal
+{
+	string path;					/*!< soubor journalu */
+	string pending;					/*!< radky, ktere jeste nejsou zapsane */
+	uint64_t appended = 0;			/*!< poradove cislo posledniho pridaneho radku */
+	uint64_t committed = 0;			/*!< radky do tohoto cisla jsou zapsane, nebo jejich zapis selhal */
+	uint64_t failedFrom = 0;		/*!< prvni radek, jehoz zapis selhal (od nej se uz nic nezapise), 0 - zadny */
+	bool stop = false;				/*!< committer ma skoncit */
+	mutex lock;						/*!< chrani pending, cisla radku a stop */
+	condition_variable wake;		/*!< probouzi committer */
+	condition_variable done;		/*!< probouzi JournalAppend po zapsani davky */
+	thread committer;				/*!< vlakno zapisujici pending na disk */
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;	/*!< handle otevreneho journalu */
+#else
+	int fd = -1;					/*!< file descriptor otevreneho journalu */
+#endif
+};
+
+/** @struct SnapshotHeader
+ *  @brief Hlavicka binarniho snapshotu nactenych dat (soubor <cesta k csv>.snap).
+ *
+ *  Za hlavickou nasleduji zaznamy UcetniData, bitmapa obsazenych ID po bajtech (MAX_ID + 1 bajtu),
+ *  chyby jako ErrorEntry (id, radek a druh chyby, vypln a file jsou 0) a nakonec nazvy kategorii, kazdy
+ *  jako uint32_t delka a znaky. Snapshot plati jen pro zdrojovy soubor se stejnou velikosti, casem zmeny
+ *  a hashem obsahu.
+ */
+struct SnapshotHeader
+{
+	char magic[8];				/*!< "UCETSNAP" */
+	uint32_t version;			/*!< SNAPSHOT_VERSION */
+	uint32_t recordSize;		/*!< sizeof(UcetniData) */
+	uint64_t sourceSize;		/*!< velikost zdrojoveho .csv souboru */
+	int64_t sourceMtime;		/*!< cas posledni zmeny zdrojoveho souboru */
+	uint64_t sourceHash;		/*!< hash obsahu zdrojoveho souboru (HashBuffer) */
+	uint64_t recordCount;		/*!< pocet zaznamu */
+	uint64_t errorCount;		/*!< pocet chyb */
+	uint64_t categoryCount;		/*!< pocet nazvu kategorii */
+	uint64_t invalidUsed;		/*!< IdIndex.invalidUsed */
+	uint64_t lineCount;			/*!< pocet radku zdrojoveho souboru */
+};
+
+/** @struct CsvScanner
+ *  @brief Postupne deleni bufferu .csv souboru na radky a pole (NextCsvRecord).
+ *
+ *  Buffer se prochazi po blocich 64 bajtu, pro kazdy blok se najednou spocita bitova maska pozic
+ *  DELIMITER a '\n' (csvBlockMask, SSE2 nebo AVX2) a pole se pak berou jen z nastavenych bitu.
+ */
+struct CsvScanner
+{
+	const char *position;	/*!< zacatek dalsiho radku */
+	const char *end;		/*!< konec bufferu */
+	const char *block;		/*!< zacatek aktualniho bloku */
+	uint64_t mask;			/*!< jeste nezpracovane pozice oddelovacu a '\n' v bloku */
+};
+
+typedef uint64_t (*CsvBlockMaskFunction)(const char*);	/*!< maska pozic DELIMITER a '\n' v 64 bajtech */
+
+/** @struct CsvChunk
+ *  @brief Cast vstupniho souboru (cele radky), kterou zpracuje jedno vlakno paralelniho nacitani.
+ *
+ *  Vlakno nevidi ostatni casti, proto je ID zaznamu jen kandidat (duplicity se resi az pri slouceni casti
+ *  v poradi souboru) a kategorie je ID v lokalnim slovniku casti. Radky s vice nez 5 poli se zpracuji
+ *  az pri slouceni, protoze opakovana pole ID zavisi na stavu indexu obsazenych ID.
+ */
+struct CsvChunk
+{
+	const char *begin = nullptr;	/*!< zacatek casti (zacatek radku) */
+	const char *end = nullptr;		/*!< konec casti (za koncem radku) */
+	vector<UcetniData> values;		/*!< zaznamy casti, ID je kandidat a kategorie je ID v lokalnim slovniku */
+	ErrorLog errorLog;				/*!< chyby zaznamu casti v poradi souboru, cisla radku jsou od zacatku casti */
+	vector<uint32_t> errorRows;		/*!< pro kazdou chybu index zaznamu ve values */
+	CategoryDictionary kategorie;	/*!< lokalni slovnik kategorii casti */
+	vector<uint32_t> slowRows;		/*!< zaznamy s vice nez 5 poli, zpracuji se az pri slouceni */
+	vector<string_view> slowLines;	/*!< radky zaznamu slowRows */
+	vector<uint32_t> slowLineNumbers;	/*!< cisla radku zaznamu slowRows v casti */
 };
 
-/** @struct ErrorText
- *  @brief Struktura obsahujici id a info o chybe.
- *  @param ErrorText.id   Id, kde je chyba obsazena
- *  @param ErrorText.info   Info o chybe
+/** @struct LedgerFile
+ *  @brief Jeden ze vstupnich souboru slucovanych do spolecne knihy (LoadLedgers).
+ *
+ *  Vlastni vlakno soubor namapuje a zpracuje jako jednu cast (ParseCsvChunk), zbytek uz dela hlavni vlakno.
  */
-struct ErrorText
+struct LedgerFile
 {
-	vector<int> id;         /*!< id ve kterem je chyba */
-	vector<string> info;    /*!< info o chybe */
+	string path;				/*!< cesta k souboru */
+	MappedFile file;			/*!< namapovany soubor */
+	bool mapped = false;		/*!< soubor se podarilo otevrit */
+	CsvChunk chunk;				/*!< cely soubor jako jedna cast */
+	vector<UcetniData> values;	/*!< zaznamy souboru po slouceni casti, pred slucovanim knih serazene podle datumu */
+	ErrorLog errorLog;			/*!< chyby zaznamu souboru */
 };
 
-void Menu(vector<UcetniData>&, ErrorText&);
-void Setup(vector<UcetniData>&, ErrorText&);
+void Menu(vector<UcetniData>&, ErrorLog&, IdIndex&);
+void Setup(vector<UcetniData>&, ErrorLog&, IdIndex&);
 string GetDataPath();
 string GetOutputHtmlPath();
 bool FileExist(string);
-vector<UcetniData> loadData(string, ErrorText&);
+vector<UcetniData> loadData(string, ErrorLog&, IdIndex&);
+vector<UcetniData> LoadInput(ErrorLog&, IdIndex&);
+vector<UcetniData> LoadLedgers(const vector<string>&, ErrorLog&, IdIndex&);
+void LoadLedgerFile(LedgerFile&);
+vector<UcetniData> MergeLedgers(vector<LedgerFile>&);
+int NamespacedId(int, size_t);
+vector<string> ExpandInputFiles(const string&);
+vector<string> ListMatchingFiles(const string&);
+bool WildcardMatch(string_view, string_view);
+bool AppendData(string, vector<UcetniData>&, ErrorLog&, IdIndex&);
+void ParseCsv(const char*, size_t, vector<UcetniData>&, ErrorLog&, IdIndex&);
+void RememberLoadedFile(const string&, const MappedFile&, uint64_t, size_t, uint32_t);
+void ReplayJournal(const string&, vector<UcetniData>&, ErrorLog&, IdIndex&);
+bool JournalAppend(Journal&, const string&);
+void JournalCommitter(Journal&);
+bool JournalOpenFile(Journal&);
+bool JournalWrite(Journal&, const string&);
+void JournalClose(Journal&);
+string JournalLine(const UcetniData&, string_view);
+bool MapFile(const string&, MappedFile&);
+void UnmapFile(MappedFile&);
+void ParseCsvBuffer(const char*, size_t, vector<UcetniData>&, ErrorLog&, IdIndex&);
+uint64_t HashBuffer(const char*, size_t);
+bool LoadSnapshot(const string&, const MappedFile&, uint64_t, vector<UcetniData>&, ErrorLog&, IdIndex&);
+bool SaveSnapshot(const string&, const MappedFile&, uint64_t, const vector<UcetniData>&, const ErrorLog&, size_t, uint32_t, const IdIndex&);
+void ParseCsvParallel(const char*, size_t, unsigned int, vector<UcetniData>&, ErrorLog&, IdIndex&);
+void ParseCsvChunk(CsvChunk&);
+void MergeCsvChunk(CsvChunk&, vector<UcetniData>&, ErrorLog&, IdIndex&);
+string_view NextCsvLine(const char*&, const char*);
+void SplitCsvFields(string_view, vector<string_view>&);
+void CsvScannerInit(CsvScanner&, const char*, const char*);
+string_view NextCsvRecord(CsvScanner&, vector<string_view>&);
+uint64_t CsvBlockMaskTail(const char*, const char*);
+uint64_t CsvBlockMaskScalar(const char*);
+#ifdef CSV_SIMD
+uint64_t CsvBlockMaskSse2(const char*);
+uint64_t CsvBlockMaskAvx2(const char*);
+#endif
+CsvBlockMaskFunction SelectCsvBlockMask();
+void ParseCsvFields(const vector<string_view>&, vector<UcetniData>&, ErrorLog&, IdIndex&, PhaseTotals&);
+unsigned int LoadThreadCount();
 void printTable(vector<UcetniData>);
 
-double CheckMoney(string, ErrorText&, int);
-bool MoneyIsNotOverMaxValue(double);
-string SpacedMoneyValue(double);
+bool CheckMoney(string_view, ErrorLog&, int, int64_t&);
+bool MoneyIsNotOverMaxValue(int64_t);
+string_view SpacedMoneyValue(int64_t, MoneyBuffer&);
 
-void AddData(vector<UcetniData>&);
-void TimeFormat(string&, unsigned int, ErrorText&, int, vector<UcetniData> &values);
-bool TryConvertFromString(string, int = 0);
+void AddData(vector<UcetniData>&, IdIndex&);
+void TimeFormat(string_view, unsigned int, ErrorLog&, int, vector<UcetniData> &values);
+NumberStatus ParseInt(string_view, int&);
+NumberStatus ParseMoney(string_view, int64_t&);
+uint32_t ParseDate(string_view, ErrorCode&);
 //void AddErrorToLog(string);
-bool IsValidID(string, vector<UcetniData>, ErrorText&);
-bool IsIdDuplicated(int, vector<UcetniData>);
-string CheckIncomeExpenditure(string);
-void PrintErrors(ErrorText&);
-void CreateHtml(vector<UcetniData>);
+bool IsValidID(string_view, const IdIndex&, ErrorLog&, int&);
+bool IsIdDuplicated(int, const IdIndex&);
+void RegisterId(int, IdIndex&);
+int FreeId(const IdIndex&);
+TypZaznamu CheckIncomeExpenditure(string_view);
+uint32_t InternCategory(string_view, CategoryDictionary&);
+string_view TrimCategory(string_view);
+const string& CategoryText(uint32_t);
+string TypeText(TypZaznamu);
+uint32_t PackDate(int, int, int);
+int DateYear(uint32_t);
+int DateMonth(uint32_t);
+int DateDay(uint32_t);
+string DateText(uint32_t);
+void PrintErrors(ErrorLog&);
+void PrintError(ostream&, const ErrorEntry&);
+void LogError(ErrorLog&, ErrorCode, int);
+const char *ErrorMessage(ErrorCode);
+string GetErrorFilePath();
+string OutputSiblingPath(const char*);
+void UpdateQueryIndex(const vector<UcetniData>&);
+vector<uint32_t> RunQuery(const vector<UcetniData>&, const Query&);
+vector<uint32_t> IntersectPostings(const vector<uint32_t>&, const vector<uint32_t>&);
+bool FindCategory(string_view, uint32_t&);
+void QueryData(const vector<UcetniData>&);
+void UpdateBalanceIndex(const vector<UcetniData>&);
+void BuildBalanceTree();
+void BalanceReserve(uint32_t);
+void BalanceAdd(uint32_t, int64_t);
+int64_t BalancePrefix(uint32_t);
+uint32_t DayNumber(uint32_t);
+int64_t BalanceUntil(uint32_t);
+int64_t BalanceBetween(uint32_t, uint32_t);
+void PrintBalance(const vector<UcetniData>&);
+void StatsCount(StatsPhase, uint64_t, uint64_t);
+void StatsMerge(const PhaseTotals&);
+void StatsCountRejected(const vector<UcetniData>&, size_t);
+void StatsReset();
+void PrintStats(const ErrorLog&);
+string JsonString(string_view);
+void CreateHtml(const vector<UcetniData>&);
+bool CreateHtmlReport(const vector<UcetniData>&, const string&);
+void CreateHtmlStream(string);
+uint32_t MonthIndex(uint32_t);
+uint64_t RecordHash(const UcetniData&);
+void UpdateHtmlCache(const vector<UcetniData>&);
+void CreateHtmlPages();
+bool WriteHtmlPage(const string&, uint64_t, map<uint32_t, MonthFragment>::const_reverse_iterator, map<uint32_t, MonthFragment>::const_reverse_iterator, int64_t, bool&);
+bool HtmlPageIsCurrent(const string&, uint64_t);
+string HtmlPagePath(const string&, int, int);
+size_t RemoveStaleHtmlPages(const string&, const vector<string>&);
+string FileName(const string&);
+bool SpillMonthRun(MonthRun&);
+bool ReadMonthRun(MonthRun&, vector<UcetniData>&);
+void HtmlBegin(HtmlWriter&);
+void HtmlMonth(HtmlWriter&, const vector<UcetniData>&, const ReportTotals&, const MonthTotals&);
+void HtmlYearTotals(HtmlWriter&, const YearTotals&);
+void HtmlEnd(HtmlWriter&);
+bool IsReportable(const UcetniData&);
+uint64_t ReportSortKey(const UcetniData&);
+void RadixSort(vector<uint64_t>&, vector<uint32_t>&);
+vector<UcetniData> SortReportData(const vector<UcetniData>&);
+ReportTotals AggregateReport(const vector<UcetniData>&);
+bool HtmlOpen(HtmlWriter&, const string&);
+void HtmlSectionEnd(HtmlWriter&);
+bool HtmlCommit(HtmlWriter&);
+HtmlWriter& operator<<(HtmlWriter&, string_view);
+HtmlWriter& operator<<(HtmlWriter&, long long);
 
 char TIME_DELIMITER = '.';		/*!< '.', '-', ':' */
 string MONEY_DELIMITER = ",";	/*!< " ", ",", "." delimeters that user can choose between to show */
+bool MONEY_HALERE = false;		/*!< zobrazovat castky i s halerema (desetinny oddelovac je '.' pro ",", jinak ',') */
+unsigned int LOAD_THREADS = 0;	/*!< pocet vlaken pro nacitani dat, 0 = podle poctu jader procesoru */
+int HTML_PAGES = 0;				/*!< rozdeleni html vystupu: 0 - jeden soubor, 1 - stranka na rok, 2 - stranka na mesic */
+int ERROR_OUTPUT = 0;			/*!< vypis chyb: 0 - vsechny, 1 - prvnich ERROR_LIMIT, 2 - vzorek ERROR_LIMIT chyb, 3 - vsechny do souboru */
+unsigned int ERROR_LIMIT = 100;	/*!< kolik chyb se vypise pri ERROR_OUTPUT 1 a 2 */
+int ID_CONFLICTS = 0;			/*!< stejne ID ve vice vstupnich souborech: 0 - prvni vyskyt vyhrava, 1 - ID podle souboru (NamespacedId) */
+bool STATS_ENABLED = false;		/*!< merit casy a pocitadla useku (StatsTimer, StatsCount) */
+PhaseStats phaseStats[PHASE_COUNT];		/*!< statistiky useku od spusteni, nebo od zapnuti statistik */
+atomic<uint64_t> rejectedStats[REJECT_COUNT + 1];	/*!< odmitnute radky podle duvodu, posledni polozka je pocet odmitnutych radku */
 string filePath;        /*!< cesta k vstupnimu souboru */
+vector<string> inputFiles;	/*!< vstupni soubory slucovane do jedne knihy, prazdne - nacita se jen filePath */
 string outputHtmlPath; /*!< cesta k vystupnimu souboru */
 const string defaultPath = "..\\vstupnidata\\data.csv";     /*!< zakladni cesta vstupu */
 const string defaultOutputHtmlpath = "..\\vystupnidata\\out.html";  /*!< zakladni cesta vystupu */
 const string inPathFolder = "..\\vstupnidata\\";  /*!< cesta do slozky se vstupnimy daty */
 const string outPathFolder = "..\\vystupnidata\\"; /*!< cesta do slozky s vystupnimi daty */
+CategoryDictionary categories;	/*!< slovnik kategorii vsech nactenych a pridanych zaznamu */
+LoadedFile loadedFile;			/*!< nactena cast vstupniho souboru, pro nacteni jen novych radku */
+Journal journal;				/*!< journal rucne pridanych zaznamu nacteneho souboru */
+HtmlCache htmlCache;			/*!< vyrenderovane mesice posledniho html vystupu */
+QueryIndex queryIndex;			/*!< index nactenych zaznamu pro dotazy */
+BalanceIndex balanceIndex;		/*!< index zustatku nactenych zaznamu */
+const CsvBlockMaskFunction csvBlockMask = SelectCsvBlockMask();	/*!< nejrychlejsi varianta pro tento procesor */
 time_t rawtime = time(nullptr);     /*!< time */
 
+#ifdef BENCHMARK
+int BenchmarkMain(int, char*[]);
+
+/**
+ * @brief Hlavni funkce benchmarku (preklad s -DBENCHMARK), misto menu spusti BenchmarkMain.
+ * @param argc pocet argumentu
+ * @param argv argumenty
+ * @return 0 pokud benchmark probehl
+ */
+int main(int argc, char *argv[])
+{
+	return BenchmarkMain(argc, argv);
+}
+#else
 /**
  * @brief Hlavni funkce programu. Vola se z ni Menu.
  * @return 0 pokud se program ukonci uspesne.
  */
 int main()
 {
-	ErrorText errorText;
+	ErrorLog errorLog;
 	vector<UcetniData> ucetniData;
-	Menu(ucetniData, errorText);
+	IdIndex idIndex;
+	atexit([]() { JournalClose(journal); });	// zapsat zbyvajici pridane zaznamy i pri exit()
+	Menu(ucetniData, errorLog, idIndex);
 
     return 0;
 }
+#endif
 
 /**
  * @brief Funkce vyvola hlavni menu
  * @param ucetniData vector ucetniData
- * @param errorText vector errorText
+ * @param errorLog vector errorLog
+ * @param idIndex index obsazenych ID
  */
-void Menu(vector<UcetniData> &ucetniData, ErrorText &errorText)
+void Menu(vector<UcetniData> &ucetniData, ErrorLog &errorLog, IdIndex &idIndex)
 {
 	int neplatnePokusy = 0;
 	do
@@ -142,6 +785,10 @@ void Menu(vector<UcetniData> &ucetniData, ErrorText &errorText)
 		cout << "3 - Pridat data do tabulky" << endl;
 		cout << "4 - Vytvorit .html soubor s tabulkou souhrnu dat" << endl;
 		cout << "5 - Ukoncit program" << endl;
+		cout << "6 - Vytvorit .html soubor primo z .csv souboru (velka data, omezena pamet)" << endl;
+		cout << "7 - Vypsat statistiky behu (JSON)" << endl;
+		cout << "8 - Dotaz nad daty (datum od - do, typ, kategorie)" << endl;
+		cout << "9 - Zustatek k datu a prijmy - vydaje mezi daty" << endl;
 
 		cout << endl << "Zadejte cislo vami pozadovane akce:" << endl;
 
@@ -153,37 +800,50 @@ void Menu(vector<UcetniData> &ucetniData, ErrorText &errorText)
 		switch (moznost)
 		{
 		case 1:
-			Setup(ucetniData, errorText);
+			Setup(ucetniData, errorLog, idIndex);
 			break;
 		case 2:
-			if (ucetniData.size() == 0) {
-				if (filePath.length() == 0)
-					ucetniData = loadData(defaultPath, errorText);
-				else
-					ucetniData = loadData(filePath, errorText);
-			}
+			if (ucetniData.size() == 0)
+				ucetniData = LoadInput(errorLog, idIndex);
 			printTable(ucetniData);
-			PrintErrors(errorText);
+			PrintErrors(errorLog);
 			break;
 		case 3:
-			if (ucetniData.size() == 0){
-				if (filePath.length() == 0)
-					ucetniData = loadData(defaultPath, errorText);
-				else
-					ucetniData = loadData(filePath, errorText);
-			}
-			AddData(ucetniData);
+			if (ucetniData.size() == 0)
+				ucetniData = LoadInput(errorLog, idIndex);
+			AddData(ucetniData, idIndex);
 			break;
 		case 4:
-			if (ucetniData.size() == 0){
-				if (filePath.length() == 0)
-					ucetniData = loadData(defaultPath, errorText);
-				else
-					ucetniData = loadData(filePath, errorText);
-			}
+			if (ucetniData.size() == 0)
+				ucetniData = LoadInput(errorLog, idIndex);
 			CreateHtml(ucetniData);
 			break;
 		case 5: exit(EXIT_SUCCESS);
+		case 6:
+			if (!inputFiles.empty())
+			{
+				// knihy z vice souboru se musi slouctit podle datumu, to jde jen v pameti
+				cout << "Vice vstupnich souboru se slouci v pameti." << endl;
+				if (ucetniData.size() == 0)
+					ucetniData = LoadInput(errorLog, idIndex);
+				CreateHtml(ucetniData);
+			}
+			else
+				CreateHtmlStream(filePath.length() == 0 ? defaultPath : filePath);
+			break;
+		case 7:
+			PrintStats(errorLog);
+			break;
+		case 8:
+			if (ucetniData.size() == 0)
+				ucetniData = LoadInput(errorLog, idIndex);
+			QueryData(ucetniData);
+			break;
+		case 9:
+			if (ucetniData.size() == 0)
+				ucetniData = LoadInput(errorLog, idIndex);
+			PrintBalance(ucetniData);
+			break;
 		default:
 			if (neplatnePokusy == 9){
 				cout << "\nProgram bude ukoncen." << endl << endl;
@@ -207,9 +867,10 @@ void Menu(vector<UcetniData> &ucetniData, ErrorText &errorText)
 /**
  * @brief Funkce podmenu s nastavenim
  * @param ucetniData vector ucetniData
- * @param errorText vector errorText
+ * @param errorLog vector errorLog
+ * @param idIndex index obsazenych ID
  */
-void Setup(vector<UcetniData> &ucetniData, ErrorText &errorText)
+void Setup(vector<UcetniData> &ucetniData, ErrorLog &errorLog, IdIndex &idIndex)
 {
 	bool back = false;
 	do
@@ -231,13 +892,29 @@ void Setup(vector<UcetniData> &ucetniData, ErrorText &errorText)
 		cout << "---------------------------------------------------------------------------------------" << endl;
 		cout << endl;
 		cout << "Nastaveni" << endl << endl;
-		cout << "Aktualni cesta k souboru:" << endl;
-		cout << (filePath.length() == 0 ? defaultPath : filePath) << endl;
+		if (inputFiles.empty())
+		{
+			cout << "Aktualni cesta k souboru:" << endl;
+			cout << (filePath.length() == 0 ? defaultPath : filePath) << endl;
+		}
+		else
+		{
+			cout << "Aktualni vstupni soubory (" << inputFiles.size() << "):" << endl;
+			for (const string &path : inputFiles)
+				cout << path << endl;
+		}
 		cout << "Aktualni cesta k vystupnimu souboru:" << endl;
 		cout << (outputHtmlPath.length() == 0 ? defaultOutputHtmlpath : outputHtmlPath) << endl << endl;
 
 		cout << "Oddelovac casu:   " + currentDate << endl;
-		cout << "Oddelovac penez:  10" + MONEY_DELIMITER + "692" + MONEY_DELIMITER + "588" + " Kc" << endl;
+		MoneyBuffer money;
+		cout << "Oddelovac penez:  " << SpacedMoneyValue(1069258800, money) << " Kc" << endl;
+		cout << "Vlakna nacitani:  " << (LOAD_THREADS == 0 ? "auto (" + to_string(LoadThreadCount()) + ")" : to_string(LOAD_THREADS)) << endl;
+		cout << "Html vystup:      " << (HTML_PAGES == 0 ? "jeden soubor" : (HTML_PAGES == 1 ? "stranka na rok" : "stranka na mesic")) << endl;
+		cout << "Konflikty ID:     " << (ID_CONFLICTS == 0 ? "prvni vyskyt vyhrava" : "ID podle souboru") << endl;
+		cout << "Statistiky:       " << (STATS_ENABLED ? "zapnuto" : "vypnuto") << endl;
+		cout << "Vypis chyb:       " << (ERROR_OUTPUT == 0 ? "vsechny" : (ERROR_OUTPUT == 1 ? "prvnich " + to_string(ERROR_LIMIT)
+			: (ERROR_OUTPUT == 2 ? "vzorek " + to_string(ERROR_LIMIT) : "do souboru " + GetErrorFilePath()))) << endl;
 		cout << endl;
 
 		cout << "Zadejte cislo akce:" << endl;
@@ -246,6 +923,12 @@ void Setup(vector<UcetniData> &ucetniData, ErrorText &errorText)
 		cout << "3 - Zmena oddelovace casu" << endl;
 		cout << "4 - Zmena oddelovace penez" << endl;
 		cout << "5 - Navrat do hlavniho menu" << endl;
+		cout << "6 - Pocet vlaken pro nacitani dat" << endl;
+		cout << "7 - Rozdeleni html vystupu na stranky" << endl;
+		cout << "8 - Zapnout / vypnout statistiky behu" << endl;
+		cout << "9 - Vypis chyb" << endl;
+		cout << "10 - Vice vstupnich souboru (seznam oddeleny ';', nebo maska *.csv)" << endl;
+		cout << "11 - Reseni stejnych ID ve vice vstupnich souborech" << endl;
 
 		int result;
 		int d;
@@ -258,12 +941,11 @@ void Setup(vector<UcetniData> &ucetniData, ErrorText &errorText)
 			filePath = GetDataPath();
 			if (filePath == "-1")
 				exit(EXIT_SUCCESS);
-			if (errorText.id.size() != 0)
-			{
-				errorText.id.clear();
-				errorText.info.clear();
-			}
-			ucetniData = loadData(filePath, errorText);
+			inputFiles.clear();
+			if (AppendData(filePath, ucetniData, errorLog, idIndex))
+				break;		// stejny soubor, na ktery se da navazat, nacetly se jen nove radky
+			errorLog = ErrorLog();
+			ucetniData = loadData(filePath, errorLog, idIndex);
 			break;
 		case 2:
 			outputHtmlPath = GetOutputHtmlPath();
@@ -295,21 +977,125 @@ void Setup(vector<UcetniData> &ucetniData, ErrorText &errorText)
 			cout << endl << "Vyberte oddelovac penez:" << endl;
 			cout << "1 - 10,692,588 Kc" << endl;
 			cout << "2 - 10 692 588 Kc" << endl;
+			cout << "3 - 10,692,588.50 Kc" << endl;
+			cout << "4 - 10 692 588,50 Kc" << endl;
 			cin >> d;
 			if (cin.fail())
 			{
 				MONEY_DELIMITER = ',';
+				MONEY_HALERE = false;
 				cin.clear();
 				cin.ignore(1000000, '\n');
 			}
-			else if (d == 1)
-				MONEY_DELIMITER = ',';
-			else if (d == 2)
-				MONEY_DELIMITER = ' ';
+			else if (d >= 1 && d <= 4)
+			{
+				MONEY_DELIMITER = (d % 2 == 1 ? ',' : ' ');
+				MONEY_HALERE = (d >= 3);
+			}
 			break;
 		case 5:
 			back = true;
 			break;
+		case 6:
+			d = 0;
+			cout << endl << "Zadejte pocet vlaken pro nacitani dat (0 - podle poctu jader, 1 - bez vlaken):" << endl;
+			cin >> d;
+			if (cin.fail() || d < 0 || d > 256)
+			{
+				LOAD_THREADS = 0;
+				cin.clear();
+				cin.ignore(1000000, '\n');
+			}
+			else
+				LOAD_THREADS = d;
+			break;
+		case 7:
+			d = 1;
+			cout << endl << "Vyberte rozdeleni html vystupu:" << endl;
+			cout << "1 - jeden soubor" << endl;
+			cout << "2 - prehled a stranka na kazdy rok" << endl;
+			cout << "3 - prehled a stranka na kazdy mesic" << endl;
+			cin >> d;
+			if (cin.fail())
+			{
+				HTML_PAGES = 0;
+				cin.clear();
+				cin.ignore(1000000, '\n');
+			}
+			else if (d >= 1 && d <= 3)
+				HTML_PAGES = d - 1;
+			break;
+		case 8:
+			if (!STATS_ENABLED)
+				StatsReset();		// statistiky se pocitaji od zapnuti
+			STATS_ENABLED = !STATS_ENABLED;
+			break;
+		case 9:
+			d = 1;
+			cout << endl << "Vyberte vypis chyb:" << endl;
+			cout << "1 - vsechny chyby do konzole" << endl;
+			cout << "2 - prvnich N chyb do konzole" << endl;
+			cout << "3 - rovnomerny vzorek N chyb do konzole" << endl;
+			cout << "4 - vsechny chyby do souboru " << GetErrorFilePath() << endl;
+			cin >> d;
+			if (cin.fail() || d < 1 || d > 4)
+			{
+				ERROR_OUTPUT = 0;
+				cin.clear();
+				cin.ignore(1000000, '\n');
+				break;
+			}
+			ERROR_OUTPUT = d - 1;
+			if (ERROR_OUTPUT == 1 || ERROR_OUTPUT == 2)
+			{
+				cout << endl << "Zadejte N:" << endl;
+				cin >> d;
+				if (cin.fail() || d < 1)
+				{
+					ERROR_LIMIT = 100;
+					cin.clear();
+					cin.ignore(1000000, '\n');
+				}
+				else
+					ERROR_LIMIT = d;
+			}
+			break;
+		case 10:
+		{
+			cout << endl << "Zadejte vstupni soubory oddelene ';', nebo masku (napr. ..\\vstupnidata\\*.csv):" << endl;
+			string list;
+			cin >> list;
+			vector<string> files = ExpandInputFiles(list);
+			if (files.empty())
+			{
+				cout << "Zadny vstupni soubor nenalezen, nastaveni se nemeni." << endl;
+				break;
+			}
+			inputFiles = files;
+			errorLog = ErrorLog();
+			ucetniData = LoadInput(errorLog, idIndex);
+			break;
+		}
+		case 11:
+			d = 1;
+			cout << endl << "Vyberte reseni stejnych ID ve vice vstupnich souborech:" << endl;
+			cout << "1 - prvni vyskyt (v poradi souboru) vyhrava, dalsi maji ID -1" << endl;
+			cout << "2 - ID podle souboru (poradi souboru * " << MAX_ID + 1 << " + ID, prvni soubor ma puvodni ID)" << endl;
+			cin >> d;
+			if (cin.fail() || d < 1 || d > 2)
+			{
+				ID_CONFLICTS = 0;
+				cin.clear();
+				cin.ignore(1000000, '\n');
+			}
+			else
+				ID_CONFLICTS = d - 1;
+			if (!inputFiles.empty())
+			{
+				errorLog = ErrorLog();
+				ucetniData = LoadInput(errorLog, idIndex);
+			}
+			break;
 		default:
 			cout << "Nespravna volba!" << endl << endl;
 			cin.clear();
@@ -447,976 +1233,4515 @@ bool FileExist (string path)
 /**
  * @brief Funkce pro nacteni dat z .csv souboru
  * @param pathToCSV cesta k souboru
- * @param errorText struktura, pro ukladani chyb ze vstupu
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, naplni se znovu podle nactenych dat
  * @return vector UcetnichDat
  */
-vector<UcetniData> loadData(string pathToCSV, ErrorText &errorText)
+vector<UcetniData> loadData(string pathToCSV, ErrorLog &errorLog, IdIndex &idIndex)
 {
-	ifstream inputData(pathToCSV);
-
-	if (inputData.fail()) {
-		// file could not be opened
-		cout << "Soubor nenalezen!" << endl;
-		cout << "Program se ukonci." << endl;
-		//cin.get();
-		exit(EXIT_FAILURE);
+	MappedFile inputData;
+	uint64_t hash;
+	{
+		StatsTimer timer(PHASE_READ);
+		if (!MapFile(pathToCSV, inputData)) {
+			// file could not be opened
+			cout << "Soubor nenalezen!" << endl;
+			cout << "Program se ukonci." << endl;
+			//cin.get();
+			exit(EXIT_FAILURE);
+		}
+		hash = HashBuffer(inputData.data, inputData.size);		// precte cely soubor
+		StatsCount(PHASE_READ, 0, inputData.size);
 	}
 
 	vector<UcetniData> values;
-	//vector<UcetniData> values = { UcetniData() };
-	//vector< vector<string> > values;  // vector of vector's strings
-	// cin.ignore();  is great for removing the annoying new lines stored at the end of the stream
+	idIndex = IdIndex();
+	queryIndex = QueryIndex();
+	balanceIndex = BalanceIndex();
+	string snapshotPath = pathToCSV + ".snap";
+	bool fromSnapshot;
+	{
+		StatsTimer timer(PHASE_SNAPSHOT);
+		fromSnapshot = LoadSnapshot(snapshotPath, inputData, hash, values, errorLog, idIndex);
+		StatsCount(PHASE_SNAPSHOT, values.size(), 0);
+	}
+	if (!fromSnapshot)
+	{
+		size_t firstError = errorLog.entries.size();
+		errorLog.line = 0;
+		ParseCsv(inputData.data, inputData.size, values, errorLog, idIndex);
+		SaveSnapshot(snapshotPath, inputData, hash, values, errorLog, firstError, errorLog.line, idIndex);	// snapshot je jen cache, chyba zapisu nevadi
+	}
+	RememberLoadedFile(pathToCSV, inputData, hash, values.size(), errorLog.line);
+	UnmapFile(inputData);
+
+	ReplayJournal(pathToCSV + ".journal", values, errorLog, idIndex);
+	StatsCountRejected(values, 0);
+	return values;
+}
+
+/**
+ * @brief Funkce nacte vstupni data podle nastaveni, vice souboru (inputFiles), nebo jeden soubor
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, naplni se znovu podle nactenych dat
+ * @return vector UcetnichDat
+ */
+vector<UcetniData> LoadInput(ErrorLog &errorLog, IdIndex &idIndex)
+{
+	if (!inputFiles.empty())
+		return LoadLedgers(inputFiles, errorLog, idIndex);
+	return loadData(filePath.length() == 0 ? defaultPath : filePath, errorLog, idIndex);
+}
 
-	if (inputData.is_open())
+/**
+ * @brief Funkce nacte nekolik .csv souboru paralelne a slouci je podle datumu do jedne knihy
+ *
+ * Soubory zpracovava LoadThreadCount() vlaken, ktera si je berou postupne (jako casti v ParseCsvParallel),
+ * takze pocet vlaken nezavisi na poctu souboru.
+ * Uvnitr souboru se ID resi stejne jako u jednoho souboru (duplicita ma ID -1). Stejne ID ve vice
+ * souborech se resi podle ID_CONFLICTS: bud vyhrava prvni vyskyt v poradi souboru, nebo se ID prevedou
+ * podle souboru (NamespacedId). Chyby jsou v poradi souboru a maji poradi souboru a jeho radek.
+ * Snapshot se pro vice souboru nepouziva a zaznamy pridane rucne jdou do journalu prvniho souboru.
+ * @param paths cesty k souborum
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, naplni se znovu podle nactenych dat
+ * @return zaznamy vsech souboru serazene podle datumu, pri stejnem datumu v poradi souboru
+ */
+vector<UcetniData> LoadLedgers(const vector<string> &paths, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	vector<LedgerFile> ledgers(paths.size());
+	for (size_t f = 0; f < ledgers.size(); f++)
 	{
-		string line;
-		vector<string> tmp;
-		int count;
-		unsigned int overallRows = 0;
+		ledgers[f].path = paths[f];
+		ledgers[f].chunk.errorLog.file = (uint16_t)(f + 1);
+	}
 
-		//go through every line
-		while (getline(inputData, line))
+	// pevny pocet vlaken, vlakna si berou soubory postupne
+	auto forEachLedger = [&ledgers](auto work)
+	{
+		atomic<size_t> nextLedger(0);
+		auto worker = [&ledgers, &nextLedger, &work]()
 		{
-			count = 0;
-			if (line.length() == 0)
-				continue;
-
-			int delimCount = 0;
-			for (unsigned int n = 0; n < line.length(); n++)
-			{
-				if (line[n] == DELIMITER && n == 0)
-				{
-					line.insert(0, " ");
-					//delimCount++;
-				}
-				if (line[n] == DELIMITER)
-				{
-					delimCount++;
-					if (n != line.length() - 1 && line[n + 1] == DELIMITER)
-						line.insert(n + 1, " ");
-				}
-			}
-			if (line[line.length() - 1] == DELIMITER)	// pokud je prazdne datum, dopln mezeru
-				line += " ";
-			if (delimCount < 4)					// detekce, jestli nejsou na radku 4 oddelovace poli, tak preskoci radek
-				continue;
-			/*while (delimCount < 4) {
-				line += ", ";
-				delimCount++;
-			}*/
+			for (size_t i = nextLedger++; i < ledgers.size(); i = nextLedger++)
+				work(ledgers[i]);
+		};
 
-			istringstream s(line);
-			string field;
-			values.push_back(UcetniData());		// add row to 'values'
+		unsigned int threads = LoadThreadCount();
+		vector<thread> pool;
+		for (unsigned int t = 1; t < threads && t < ledgers.size(); t++)
+			pool.emplace_back(worker);
+		worker();			// hlavni vlakno pracuje taky
+		for (thread &t : pool)
+			t.join();
+	};
+	forEachLedger(LoadLedgerFile);
 
-			while (getline(s, field, DELIMITER))
-			{
-				//Push back new subject created with default constructor.
-				//Vector now has 1 element @ index 0, so modify it.
-				//Add a new element if you want another: again like: values.push_back(UcetniData());
-				if (count == 3) // if (count == 0 || count == 3)
-				{
-					if (!TryConvertFromString(field, count))
-					{
-						//values.pop_back();
-						//overallRows--;
-						//break;
-					}
-				}
-				if (count == 0)
-				{
-					if (!TryConvertFromString(field, count))
-					{
-						field = "-1";
-					}
-				}
+	idIndex = IdIndex();
+	queryIndex = QueryIndex();
+	balanceIndex = BalanceIndex();
+	loadedFile = LoadedFile();		// na sloucenou knihu se neda navazat (AppendData)
+	for (size_t f = 0; f < ledgers.size(); f++)
+	{
+		LedgerFile &ledger = ledgers[f];
+		if (!ledger.mapped)
+		{
+			cout << "Soubor nenalezen: " << ledger.path << endl;
+			continue;
+		}
 
-				switch (count)
-				{
-				case 0: values[overallRows].ID = IsValidID(field, values, errorText) ? stoi(field) : -1; break;	// stoi(str) convert str to int
-				case 1: values[overallRows].prijemVydaj = CheckIncomeExpenditure(field); break;
-				case 2: values[overallRows].kategorie = field; break;
-				case 3: values[overallRows].castka = CheckMoney(field, errorText, values[overallRows].ID); break;
-				case 4:
-					TimeFormat(field, overallRows, errorText, values[overallRows].ID, values);	// check for correct time
-					break;
-				default:
-					break;
-				}
-				if (count == 4)
-					count = 0;
-				else
-					count++;
-			}
-			overallRows += 1;
+		// duplicity uvnitr souboru a kategorie do globalniho slovniku, v poradi souboru
+		IdIndex fileIds;
+		ledger.errorLog.file = (uint16_t)(f + 1);
+		ledger.values.reserve(ledger.chunk.values.size());
+		MergeCsvChunk(ledger.chunk, ledger.values, ledger.errorLog, fileIds);
+		ledger.chunk = CsvChunk();
+		UnmapFile(ledger.file);
+
+		// ID obsazena drivejsimi soubory, vcetne ID prepsanych na radcich s vice nez 5 poli (stejne jako u jednoho souboru)
+		bitset<MAX_ID + 1> changed;		// ID zaznamu souboru, ktera se zmenila
+		for (UcetniData &zaznam : ledger.values)
+		{
+			if (zaznam.ID == -1 || (ID_CONFLICTS == 0 && !IsIdDuplicated(zaznam.ID, idIndex)))
+				continue;
+			changed.set(zaznam.ID);
+			zaznam.ID = (ID_CONFLICTS == 1 ? NamespacedId(zaznam.ID, f) : -1);
+			fileIds.invalidUsed = fileIds.invalidUsed || zaznam.ID == -1;
+			RegisterId(zaznam.ID, idIndex);		// ID podle souboru jdou do IdIndex.namespaced
+		}
+		if (ID_CONFLICTS == 0 || f == 0)
+			idIndex.used |= fileIds.used;		// ID 0 - MAX_ID dalsich souboru jsou podle souboru, volna pro AddData
+		idIndex.invalidUsed = idIndex.invalidUsed || fileIds.invalidUsed;
+
+		// chyby maji ID zaznamu, stejne ID ma v souboru nejvys jeden zaznam
+		for (ErrorEntry &entry : ledger.errorLog.entries)
+		{
+			if (entry.id >= 0 && entry.id <= MAX_ID && changed.test(entry.id))
+				entry.id = (ID_CONFLICTS == 1 ? NamespacedId(entry.id, f) : -1);
 		}
+		errorLog.entries.insert(errorLog.entries.end(), ledger.errorLog.entries.begin(), ledger.errorLog.entries.end());
+		for (int code = 0; code < ERROR_CODE_COUNT; code++)
+			errorLog.counts[code] += ledger.errorLog.counts[code];
+		ledger.errorLog = ErrorLog();
 	}
+
+	// k-way slouceni potrebuje soubory serazene podle datumu, radi se stejnymi vlakny
+	forEachLedger([](LedgerFile &ledger)
+	{
+		auto byDate = [](const UcetniData &a, const UcetniData &b) { return a.datum < b.datum; };
+		if (!is_sorted(ledger.values.begin(), ledger.values.end(), byDate))
+			stable_sort(ledger.values.begin(), ledger.values.end(), byDate);
+	});
+
+	vector<UcetniData> values = MergeLedgers(ledgers);
+	cout << "Nacteno souboru: " << paths.size() << ", zaznamu: " << values.size() << endl;
+
+	errorLog.file = 0;
+	ReplayJournal(paths[0] + ".journal", values, errorLog, idIndex);
+	StatsCountRejected(values, 0);
 	return values;
 }
 
 /**
- * @brief Funkce vypise do konzole, do tabulky data z .csv souboru
- * @param val vector ucetnich dat
+ * @brief Funkce namapuje a zpracuje jeden vstupni soubor, vola se z vlaken LoadLedgers
+ *
+ * Stejne jako ParseCsvChunk nesaha na zadny sdileny stav, soubor zustane namapovany do slouceni.
+ * @param ledger vstupni soubor, vysledky se ulozi do nej
  */
-void printTable(vector<UcetniData> val)
+void LoadLedgerFile(LedgerFile &ledger)
 {
-	printf(" ______ ________ _________________________ _____________ ____________\n");
-	printf("|%4s  |  %-5s | %-6s %-16s |%-1s%-12s|   %-9s|\n", "ID", "Typ", " ", "Kategorie", " ", "Castka [Kc]", "Datum");
-	printf("|======+========+=========================+=============+============|\n");
-	for (unsigned int i = 0; i < val.size(); i++)
 	{
-		//prinf c-style
-		//If, for some reason, you need to extract the C-style string, you can use the c_str()
-		//method of std::string to get a const char * that is null-terminated. Use it like: myString.c_str()
-		string date = val[i].day + TIME_DELIMITER + val[i].month + TIME_DELIMITER + val[i].year;
-		printf("|%5i | %-6s | %-23.23s | %11.11s | %-10s |\n", val[i].ID, val[i].prijemVydaj.c_str(), val[i].kategorie.c_str(), SpacedMoneyValue(val[i].castka).c_str(), date.c_str());
+		StatsTimer timer(PHASE_READ);
+		ledger.mapped = MapFile(ledger.path, ledger.file);
+		if (!ledger.mapped)
+			return;
+		StatsCount(PHASE_READ, 0, ledger.file.size);
 	}
-	printf("|______|________|_________________________|_____________|____________|\n\n");
+	ledger.chunk.begin = ledger.file.data;
+	ledger.chunk.end = ledger.file.data + ledger.file.size;
+	ParseCsvChunk(ledger.chunk);
 }
 
 /**
- * @brief Funkce kontroluje zadanou castku, jestli je cislo a jestli neprekrocila limit 999,999,999.5 Kc, nebo neni zaporna
- * @param money zadana castka ve stringu
- * @param errorText struktura pro ukladani chyb
- * @param id pro zaznam chyby
- * @return vraci zadanou castku, jestli odpovida podminkam, -1 vraci, pokud zadana castka neni cislo, -2 vraci jestli je moc velka castka, nebo zaporna
+ * @brief Funkce slouci zaznamy souboru serazene podle datumu do jedne knihy (k-way merge haldou)
+ *
+ * V halde je pro kazdy soubor jeho dalsi zaznam s klicem datum << 32 | poradi souboru, takze pri
+ * stejnem datumu jdou zaznamy v poradi souboru. Posledni zbyvajici soubor se uz jen zkopiruje.
+ * @param ledgers vstupni soubory se serazenymi zaznamy
+ * @return zaznamy vsech souboru serazene podle datumu
  */
-double CheckMoney(string money, ErrorText &errorText, int id)
+vector<UcetniData> MergeLedgers(vector<LedgerFile> &ledgers)
 {
-	bool isNotMax;
-	double doubleMoney;
-
-	if (TryConvertFromString(money))
+	size_t total = 0;
+	vector<pair<uint64_t, size_t>> heap;		// klic dalsiho zaznamu, jeho pozice v souboru
+	for (size_t f = 0; f < ledgers.size(); f++)
 	{
-		doubleMoney = stod(money);
-		isNotMax = MoneyIsNotOverMaxValue(doubleMoney);
+		total += ledgers[f].values.size();
+		if (!ledgers[f].values.empty())
+			heap.emplace_back((uint64_t)ledgers[f].values[0].datum << 32 | f, 0);
+	}
+	auto later = [](const pair<uint64_t, size_t> &a, const pair<uint64_t, size_t> &b) { return a.first > b.first; };
+	make_heap(heap.begin(), heap.end(), later);
 
-		if (isNotMax)
+	vector<UcetniData> merged;
+	merged.reserve(total);
+	while (heap.size() > 1)
+	{
+		pop_heap(heap.begin(), heap.end(), later);
+		pair<uint64_t, size_t> &next = heap.back();
+		const vector<UcetniData> &values = ledgers[(uint32_t)next.first].values;
+		merged.push_back(values[next.second++]);
+		if (next.second < values.size())
 		{
-			// money value is correct
-			return doubleMoney;
+			next.first = (uint64_t)values[next.second].datum << 32 | (uint32_t)next.first;
+			push_heap(heap.begin(), heap.end(), later);
 		}
 		else
-		{
-			// money value is bigger than 999,999,999
-			errorText.id.push_back(id);
-			errorText.info.push_back("Penezni castka presahla maxima 999,999,999 Kc, nebo je zaporna.");
-			return -2;
-		}
+			heap.pop_back();
 	}
-	else
+	if (!heap.empty())
 	{
-		// money is not a number
-		errorText.id.push_back(id);
-		errorText.info.push_back("Zadana penezni castka neni cislo.");
-		return -1;
+		const vector<UcetniData> &values = ledgers[(uint32_t)heap[0].first].values;
+		merged.insert(merged.end(), values.begin() + heap[0].second, values.end());
 	}
+	return merged;
 }
 
 /**
- * @brief Funkce pro kontrolu velikosti penezni castky
- * @param money zadana castka
- * @return true, pokud castka neprekrocila danou velikost, false pokud prekrocila 999999999.555
+ * @brief Funkce prevede ID zaznamu souboru na ID podle souboru, prvni soubor ma puvodni ID
+ * @param id platne ID zaznamu 0 - MAX_ID
+ * @param file poradi souboru od 0
+ * @return poradi souboru * (MAX_ID + 1) + id
  */
-bool MoneyIsNotOverMaxValue(double money)
+int NamespacedId(int id, size_t file)
 {
-	if (money >= 999999999.555 || money < 0.0)
-		return false;
-	else
-		return true;
+	return (int)file * (MAX_ID + 1) + id;
 }
 
 /**
- * @brief Funkce pro prevod penezni castky na formatovany vzhled s oddelovanim po trech cislech
- * @param castka
- * @return string naformatovane penezni castky, nebo vrati "x", pokud je castka -1, nebo -2 ( -1 a -2 znaci nespravny vstup diky kontrole ve funkci CheckMoney)
+ * @brief Funkce prevede zadany seznam vstupnich souboru na cesty k existujicim souborum
+ *
+ * Polozky jsou oddelene ';'. Polozka s '*' nebo '?' v nazvu souboru je maska (ListMatchingFiles),
+ * ostatni se hledaji stejne jako v GetDataPath (i ve slozce vstupnich dat a s priponou .csv).
+ * Neexistujici soubory se vypisou a vynechaji, stejny soubor se nacte jen jednou.
+ * @param list seznam souboru
+ * @return cesty k souborum v zadanem poradi, nejvic MAX_INPUT_FILES
  */
-string SpacedMoneyValue(double castka)
+vector<string> ExpandInputFiles(const string &list)
 {
-	int roundedToInt = (int)round(castka);
-	string money = to_string(roundedToInt);
-	string spacedMoney = "";
-	short count = 0;
-
-	if (castka == -1)
+	vector<string> files;
+	size_t start = 0;
+	while (start <= list.size())
 	{
-		// Money value is not a number
-		// "Neni cislo"
-		return "x";
+		size_t end = list.find(';', start);
+		if (end == string::npos)
+			end = list.size();
+		string item = list.substr(start, end - start);
+		start = end + 1;
+		if (item.empty())
+			continue;
+
+		vector<string> found;
+		if (item.find_first_of("*?") != string::npos)
+			found = ListMatchingFiles(item);
+		else if (FileExist(item))
+			found.push_back(item);
+		else if (FileExist(inPathFolder + item))
+			found.push_back(inPathFolder + item);
+		else if (FileExist(inPathFolder + item + ".csv"))
+			found.push_back(inPathFolder + item + ".csv");
+		if (found.empty())
+			cout << "Soubor nenalezen: " << item << endl;
+
+		for (const string &path : found)
+		{
+			if (find(files.begin(), files.end(), path) != files.end())
+				continue;
+			if (files.size() == MAX_INPUT_FILES)
+			{
+				cout << "Nacte se jen prvnich " << MAX_INPUT_FILES << " souboru." << endl;
+				return files;
+			}
+			files.push_back(path);
+		}
 	}
-	else if (castka == -2)
+	return files;
+}
+
+/**
+ * @brief Funkce najde soubory, jejichz nazev odpovida masce ('*' libovolne znaky, '?' jeden znak)
+ *
+ * Maska muze byt jen v nazvu souboru, ne ve slozkach. Maska bez slozky se hleda v aktualni slozce
+ * a pokud tam nic neodpovida, tak ve slozce vstupnich dat.
+ * @param pattern cesta s maskou
+ * @return cesty k odpovidajicim souborum serazene podle nazvu
+ */
+vector<string> ListMatchingFiles(const string &pattern)
+{
+	size_t slash = pattern.find_last_of("/\\");
+	if (slash == string::npos)
 	{
-		// Money value is too big number (max is: 999,999,999)
-		// "Prilis velka castka"
-		return "x";
+		vector<string> found = ListMatchingFiles("./" + pattern);
+		for (string &path : found)
+			path.erase(0, 2);		// bez "./"
+		return (found.empty() ? ListMatchingFiles(inPathFolder + pattern) : found);
 	}
 
-	for (int i = money.length() - 1; i >= 0; i--)
+	string folder = pattern.substr(0, slash + 1);
+	string_view mask = string_view(pattern).substr(slash + 1);
+	vector<string> found;
+#ifdef _WIN32
+	WIN32_FIND_DATAA entry;
+	HANDLE search = FindFirstFileA((folder + "*").c_str(), &entry);
+	if (search == INVALID_HANDLE_VALUE)
+		return found;
+	do
 	{
-		if (count % 3 == 0 && count != 0) {
-			spacedMoney.insert(0, MONEY_DELIMITER); // insert(pos, string) pouzitelne pro vkladani stringu do stringu na danou pozici
-		}
-		spacedMoney.insert(0, 1, money[i]);			// insert(pos, kolikrat to tam chceme vlozit, char) vkladani znaku typu char do stringu na danou pozici
-		count++;
+		if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && WildcardMatch(entry.cFileName, mask))
+			found.push_back(folder + entry.cFileName);
+	} while (FindNextFileA(search, &entry));
+	FindClose(search);
+#else
+	DIR *directory = opendir(folder.c_str());
+	if (directory == nullptr)
+		return found;
+	while (dirent *entry = readdir(directory))
+	{
+		struct stat info;
+		string path = folder + entry->d_name;
+		if (WildcardMatch(entry->d_name, mask) && stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+			found.push_back(path);
 	}
-	return spacedMoney;
+	closedir(directory);
+#endif
+	sort(found.begin(), found.end());
+	return found;
 }
 
 /**
- * @brief Funkce pro pridani novych dat zadavanych uzivatelem z klavesnice
- * @param ucetniData kde se ulozi data k ostatnim datum nactenym z csv
+ * @brief Funkce porovna nazev s maskou ('*' libovolne znaky, '?' jeden znak)
+ * @param name nazev souboru
+ * @param mask maska
+ * @return true pokud nazev odpovida masce
  */
-void AddData(vector<UcetniData> &ucetniData)
+bool WildcardMatch(string_view name, string_view mask)
 {
-	bool canAdd = true;
-		ucetniData.push_back(UcetniData());
-
-		string date;
-		unsigned int lengthData = ucetniData.size() - 1;
-		int lastId = ucetniData[lengthData - 1].ID;
-		char category[24];
-
-		while (IsIdDuplicated(lastId, ucetniData))
+	size_t n = 0, m = 0;
+	size_t starMask = string_view::npos, starName = 0;		// posledni '*' a kde v nazvu za nim zkousime pokracovat
+	while (n < name.size())
+	{
+		if (m < mask.size() && (mask[m] == '?' || mask[m] == name[n]))
 		{
-			if (lastId < -1)
-			{
-				lastId = 0;
-				lastId++;
-			}
-			else if (lastId > 9999)
-			{
-				canAdd = false;
-				break;
-			}
-			else
-				lastId++;
+			n++;
+			m++;
 		}
-
-		if (!canAdd)
+		else if (m < mask.size() && mask[m] == '*')
 		{
-			int idTmp = 0;
-			while (IsIdDuplicated(idTmp, ucetniData))
-			{
-				if (idTmp > 9999)
-				{
-					canAdd = false;
-					break;
-				}
-				else
-					idTmp++;
-			}
+			starMask = m++;
+			starName = n;
+		}
+		else if (starMask != string_view::npos)
+		{
+			m = starMask + 1;
+			n = ++starName;
 		}
+		else
+			return false;
+	}
+	while (m < mask.size() && mask[m] == '*')
+		m++;
+	return m == mask.size();
+}
 
-		ucetniData[lengthData].ID = lastId;
+/**
+ * @brief Funkce nacte jen radky pripsane na konec uz nacteneho souboru
+ *
+ * Navazat se da jen na stejny soubor, jehoz nactena cast se nezmenila (stejny hash) a ke kterym
+ * nebyly pridany zaznamy rucne. Nove radky se zpracuji stejne jako pri nacteni celeho souboru,
+ * takze ID, zaznamy i chyby jsou stejne, jako kdyby se nacetl cely soubor znovu.
+ * @param pathToCSV cesta k souboru
+ * @param ucetniData nactena data, pridaji se k nim nove zaznamy
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID
+ * @return true pokud se nove radky nacetly, false pokud se musi nacist cely soubor (nic se nezmeni)
+ */
+bool AppendData(string pathToCSV, vector<UcetniData> &ucetniData, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	if (loadedFile.path.empty() || loadedFile.path != pathToCSV || loadedFile.records != ucetniData.size())
+		return false;
 
-		if (canAdd)
-		{
-			cout << "Zadejte cislo akce:" << endl;
-			cout << "1 - prijem\n2 - vydaj" << endl;
-			int num;
-			if (cin >> num)
-			{
-				if (num == 1)
-					ucetniData[lengthData].prijemVydaj = "prijem";
-				else if (num == 2)
-					ucetniData[lengthData].prijemVydaj = "vydaj";
-				else
-				{
-					cout << "Neplatny vstup." << endl << endl;
-					canAdd = false;
-				}
-			}
-			else {
-				cout << "Neplatny vstup." << endl << endl;
-				canAdd = false;
-				//break;
-			}
+	MappedFile inputData;
+	if (!MapFile(pathToCSV, inputData))
+		return false;
+	if (inputData.size < loadedFile.offset || HashBuffer(inputData.data, loadedFile.offset) != loadedFile.prefixHash)
+	{
+		// soubor se zmenil i v uz nactene casti
+		UnmapFile(inputData);
+		return false;
+	}
 
-			if (canAdd)
-			{
-				cout << "Zadejte kratky popis max 23 znaku (nepouzivejte znak \",\"):" << endl;
-				cin.ignore();
-				cin.getline(category, 23);
-				ucetniData[lengthData].kategorie = string(category);
-				//cin.ignore(INT_MAX);
+	size_t before = ucetniData.size();
+	errorLog.line = loadedFile.lines;		// cisla radku chyb pokracuji za nactenou casti
+	ParseCsv(inputData.data + loadedFile.offset, inputData.size - loadedFile.offset, ucetniData, errorLog, idIndex);
+	StatsCountRejected(ucetniData, before);
+	RememberLoadedFile(pathToCSV, inputData, HashBuffer(inputData.data, inputData.size), ucetniData.size(), errorLog.line);
+	UnmapFile(inputData);
 
-				cout << "Zadejte castku v Kc:" << endl;
-				double money;
-				if (cin >> money)
-				{
-					if (MoneyIsNotOverMaxValue(money))
-					{
-						ucetniData[lengthData].castka = money;
-					}
-					else
-					{
-						cout << "Zadali jste prilis velkou, nebo zapornou castku!" << endl;
-						canAdd = false;
-						//break;
-					}
+	cout << "Nacteno novych zaznamu: " << ucetniData.size() - before << endl;
+	return true;
+}
 
-				}
-				else
-				{
-					cout << "Zadali jste neplatnou castku penez!" << endl;
-					canAdd = false;
-					//break;
-				}
-			}
-			if (canAdd)
-			{
-				//struct tm timeinfo;
-				//localtime_s(&timeinfo, &t);
-				//errno_t error = localtime_s(&timeinfo, &t);
+/**
+ * @brief Funkce prehraje journal pridanych zaznamu za nactena data a pripravi ho pro dalsi zaznamy
+ *
+ * Journal je ve formatu .csv souboru, takze se zpracuje stejne jako on. Neuplny posledni radek
+ * (pad programu behem zapisu) se ignoruje a pri dalsim zapisu se z journalu odrizne.
+ * @param path cesta k journalu
+ * @param values nactena data, pridaji se k nim zaznamy z journalu
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID
+ */
+void ReplayJournal(const string &path, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	JournalClose(journal);		// vsechny pridane zaznamy musi byt na disku, nez se journal precte
+	journal.path = path;
 
-				//cout << asctime_s(localtime(&t)) << '\n';
-				//tm *ltm = localtime(&now);
-				// print various components of tm structure.
-				//cout << "Year" << 1970 + ltm->tm_year << endl;
-				//cout << "Month: " << 1 + ltm->tm_mon << endl;
-				//cout << "Day: " << ltm->tm_mday << endl;
+	MappedFile file;
+	if (!MapFile(path, file))
+		return;		// zadne pridane zaznamy
 
-                struct tm *timeinfo;
-                time(&rawtime);
-                timeinfo = localtime ( &rawtime );
+	size_t length = file.size;
+	while (length > 0 && file.data[length - 1] != '\n')
+		length--;
+	size_t before = values.size();
+	errorLog.line = 0;		// chyby z journalu maji cisla radku journalu
+	ParseCsvBuffer(file.data, length, values, errorLog, idIndex);
+	UnmapFile(file);
 
-                string cDay = to_string(timeinfo->tm_mday);
-                string cMonth = to_string(1 + timeinfo->tm_mon);
-                string cYear = to_string(1900 + timeinfo->tm_year);
+	if (values.size() != before)
+		cout << "Nacteno pridanych zaznamu z " << path << ": " << values.size() - before << endl;
+}
 
-                if (cDay.length() < 2)
-                    cDay.insert(0, "0");
-                if (cMonth.length() < 2)
-                    cMonth.insert(0, "0");
-                date = cDay + TIME_DELIMITER + cMonth + TIME_DELIMITER + cYear;
+/**
+ * @brief Funkce prida radek do journalu a pocka, az ho vlakno committer zapise a potvrdi fsync
+ * @param j journal
+ * @param line radek ve formatu .csv souboru vcetne '\n'
+ * @return false pokud journal nelze otevrit, nebo se zapis tohoto radku nepodaril
+ */
+bool JournalAppend(Journal &j, const string &line)
+{
+	unique_lock<mutex> guard(j.lock);
+	if (!j.committer.joinable())
+	{
+		if (!JournalOpenFile(j))
+			return false;
+		j.stop = false;
+		j.failedFrom = 0;
+		j.committer = thread(JournalCommitter, ref(j));
+	}
+	if (j.failedFrom != 0)
+		return false;		// za neuplny zapis se dalsi radky nepripisuji
 
-                //
-				//string cDay = to_string((&timeinfo)->tm_mday);
-				//string cMonth = to_string(1 + (&timeinfo)->tm_mon);
-				//string cYear = to_string(1900 + (&timeinfo)->tm_year);
+	j.pending += line;
+	uint64_t sequence = ++j.appended;
+	j.wake.notify_one();
+	j.done.wait(guard, [&j, sequence]() { return j.committed >= sequence; });
+	return j.failedFrom == 0 || sequence < j.failedFrom;
+}
 
-				//if (cDay.length() < 2)
-				//	cDay.insert(0, "0");
-				//if (cMonth.length() < 2)
-				//	cMonth.insert(0, "0");
+/**
+ * @brief Vlakno journalu, zapisuje nasbirane radky najednou a kazdou davku potvrdi jednim fsync
+ * @param j journal
+ */
+void JournalCommitter(Journal &j)
+{
+	unique_lock<mutex> guard(j.lock);
+	while (true)
+	{
+		j.wake.wait(guard, [&j]() { return j.stop || !j.pending.empty(); });
+		if (j.pending.empty())
+			break;		// stop a neni co zapsat
+		if (!j.stop)
+			j.wake.wait_for(guard, chrono::milliseconds(JOURNAL_GROUP_COMMIT_MS), [&j]() { return j.stop; });
 
-				//date = cDay + TIME_DELIMITER + cMonth + TIME_DELIMITER + cYear;
-				ucetniData[lengthData].day = cDay;
-				ucetniData[lengthData].month = cMonth;
-				ucetniData[lengthData].year = cYear;
-				//string date = to_string((&timeinfo)->tm_mday) + TIME_DELIMITER + to_string(1 + (&timeinfo)->tm_mon) + TIME_DELIMITER + to_string( 1900 + (&timeinfo)->tm_year);
-			}
-			if (canAdd)
-			{
-				cout << endl << "Zadali jste:" << endl;
-				cout << "ID: " << ucetniData[lengthData].ID << " |  " << ucetniData[lengthData].prijemVydaj << "\t" << ucetniData[lengthData].kategorie << "\t" << fixed << setprecision(0) << ucetniData[lengthData].castka << "\t" << date << endl;
-				cout << endl;
-			}
-			else
-			{
-				ucetniData.pop_back();
-			}
+		string batch;
+		batch.swap(j.pending);
+		uint64_t last = j.appended;
+		bool ok = j.failedFrom == 0;
+		guard.unlock();
+		ok = ok && JournalWrite(j, batch);
+		guard.lock();
+		if (!ok && j.failedFrom == 0)
+			j.failedFrom = j.committed + 1;
+		j.committed = last;
+		j.done.notify_all();
+	}
+}
 
-		}
-		else
-		{
-			cout << "Nelze pridat dalsi polozku." << endl;
-			ucetniData.pop_back();
-			//break;
-		}
+/**
+ * @brief Funkce otevre soubor journalu pro pripisovani, neuplny posledni radek se odrizne
+ * @param j journal
+ * @return true pokud se soubor podarilo otevrit
+ */
+bool JournalOpenFile(Journal &j)
+{
+	size_t length = 0;
+	MappedFile existing;
+	if (MapFile(j.path, existing))
+	{
+		length = existing.size;
+		while (length > 0 && existing.data[length - 1] != '\n')
+			length--;
+		UnmapFile(existing);
+	}
+
+#ifdef _WIN32
+	j.file = CreateFileA(j.path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (j.file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER position;
+	position.QuadPart = length;
+	if (!SetFilePointerEx(j.file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(j.file))
+	{
+		CloseHandle(j.file);
+		j.file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+#else
+	j.fd = open(j.path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (j.fd < 0)
+		return false;
+	if (ftruncate(j.fd, length) != 0)
+	{
+		close(j.fd);
+		j.fd = -1;
+		return false;
+	}
+#endif
+	return true;
 }
 
 /**
- * @brief Funkce prevede ruzne formaty datumu na jeden stejny
- * @param time - zadany cas
- * @param overallRows - pocet radku
- * @param errorText - struktura errorTextu
- * @param id - id pro errory
- * @param values - ucetnidata
- * @return true, pokud castka neprekrocila danou velikost, false pokud prekrocila 999999999.555
+ * @brief Funkce zapise davku radku na konec journalu a pocka, az bude na disku
+ * @param j journal
+ * @param batch radky k zapsani
+ * @return true pokud se zapis i fsync podaril
  */
-void TimeFormat(string &time, unsigned int overallRows, ErrorText &errorText, int id, vector<UcetniData> &values)
+bool JournalWrite(Journal &j, const string &batch)
 {
-	// funkce pro zavedeni jednotneho formatovani casu a kontrola, jestli vubec existuje
-	Months m;
-	string tmp;
-	vector <string> newTime;
-	unsigned int pos = 0;
-	int numberOfDelimiters = 0;
-	bool correctDate = true;
-	bool wrongDay = false, wrongMonth = false;
-	int day, month, year = 0;
-	int completDate = 0;
+	size_t written = 0;
+#ifdef _WIN32
+	while (written < batch.size())
+	{
+		DWORD count;
+		if (!WriteFile(j.file, batch.data() + written, (DWORD)(batch.size() - written), &count, nullptr))
+			return false;
+		written += count;
+	}
+	return FlushFileBuffers(j.file);
+#else
+	while (written < batch.size())
+	{
+		ssize_t count = write(j.fd, batch.data() + written, batch.size() - written);
+		if (count < 0)
+			return false;
+		written += count;
+	}
+	return fsync(j.fd) == 0;
+#endif
+}
 
-	for (unsigned int i = 0; i < time.size() && correctDate; i++)
+/**
+ * @brief Funkce ukonci committer a zavre soubor journalu
+ * @param j journal
+ */
+void JournalClose(Journal &j)
+{
+	if (j.committer.joinable())
 	{
-		if (time[i] == ' ' || time[i] == '.' || time[i] == '-' || time[i] == ':')
 		{
-			tmp = time.substr(pos, i - pos);
+			lock_guard<mutex> guard(j.lock);
+			j.stop = true;
+			j.wake.notify_one();
+		}
+		j.committer.join();		// chyby zapisu uz ohlasil JournalAppend u kazdeho radku
+	}
+#ifdef _WIN32
+	if (j.file != INVALID_HANDLE_VALUE)
+		CloseHandle(j.file);
+	j.file = INVALID_HANDLE_VALUE;
+#else
+	if (j.fd >= 0)
+		close(j.fd);
+	j.fd = -1;
+#endif
+}
 
-			switch (numberOfDelimiters)
+/**
+ * @brief Funkce vytvori radek journalu pro zaznam, ve formatu, ktery cte ParseCsvBuffer
+ * @param zaznam platny zaznam
+ * @param category kategorie tak, jak ji zadal uzivatel
+ * @return radek "ID,typ,kategorie,castka,DD.MM.RRRR" vcetne '\n'
+ */
+string JournalLine(const UcetniData &zaznam, string_view category)
+{
+	char money[32];
+	int length = snprintf(money, sizeof(money), "%lld.%02d", (long long)(zaznam.castka / 100), (int)(zaznam.castka % 100));
+	char date[16];
+	snprintf(date, sizeof(date), "%02d.%02d.%04d", DateDay(zaznam.datum), DateMonth(zaznam.datum), DateYear(zaznam.datum));
+
+	string line = to_string(zaznam.ID);
+	line += DELIMITER;
+	line += TypeText(zaznam.prijemVydaj);
+	line += DELIMITER;
+	line.append(category.data(), category.size());
+	line += DELIMITER;
+	line.append(money, length);
+	line += DELIMITER;
+	line += date;
+	line += '\n';
+	return line;
+}
+
+/**
+ * @brief Funkce zpracuje buffer s obsahem .csv souboru, velky buffer vice vlakny
+ * @param buffer obsah souboru
+ * @param length delka obsahu v bajtech
+ * @param values ucetni data, kam se pridavaji nactene radky
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID
+ */
+void ParseCsv(const char *buffer, size_t length, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	unsigned int threads = LoadThreadCount();
+	if (threads > 1 && length >= PARALLEL_MIN_SIZE)
+		ParseCsvParallel(buffer, length, threads, values, errorLog, idIndex);
+	else
+		ParseCsvBuffer(buffer, length, values, errorLog, idIndex);
+}
+
+/**
+ * @brief Funkce si zapamatuje nactenou cast souboru pro AppendData
+ *
+ * Pokud soubor nekonci '\n', posledni radek muze jeste pokracovat, a proto se na soubor nenavazuje.
+ * @param path cesta k souboru
+ * @param file namapovany soubor, cely nacteny
+ * @param hash hash celeho obsahu souboru
+ * @param records pocet zaznamu nactenych ze souboru
+ * @param lines pocet radku souboru
+ */
+void RememberLoadedFile(const string &path, const MappedFile &file, uint64_t hash, size_t records, uint32_t lines)
+{
+	loadedFile = LoadedFile();
+	if (file.size != 0 && file.data[file.size - 1] != '\n')
+		return;
+
+	loadedFile.path = path;
+	loadedFile.offset = file.size;
+	loadedFile.prefixHash = hash;
+	loadedFile.records = records;
+	loadedFile.lines = lines;
+}
+
+/**
+ * @brief Funkce spocita 64bitovy hash obsahu bufferu (po 8 bajtech ve 4 nezavislych prubezich, neni kryptograficky)
+ * @param data buffer
+ * @param length delka bufferu v bajtech
+ * @return hash
+ */
+uint64_t HashBuffer(const char *data, size_t length)
+{
+	const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+	uint64_t h[4] = { 0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL };
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32)
+	{
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint64_t word;
+			memcpy(&word, data + i + 8 * lane, 8);
+			h[lane] = (h[lane] ^ word) * multiplier;
+			h[lane] ^= h[lane] >> 32;
+		}
+	}
+
+	uint64_t hash = length;
+	for (int lane = 0; lane < 4; lane++)
+		hash = (hash ^ h[lane]) * multiplier;
+	for (; i < length; i++)
+		hash = (hash ^ (unsigned char)data[i]) * 0x100000001B3ULL;
+	return hash ^ (hash >> 29);
+}
+
+/**
+ * @brief Funkce nacte ucetni data ze snapshotu, pokud odpovida zdrojovemu souboru
+ *
+ * Snapshot se namapuje do pameti, zaznamy se zkopiruji najednou a kategorie se prevedou na ID
+ * v aktualnim slovniku kategorii. Texty se znovu nekontroluji, jen rozsahy poli zaznamu a chyb,
+ * a kategorie se do slovniku pridaji az u platneho snapshotu.
+ * @param path cesta ke snapshotu
+ * @param source namapovany zdrojovy .csv soubor
+ * @param hash hash obsahu zdrojoveho souboru
+ * @param values sem se ulozi zaznamy
+ * @param errorLog sem se pridaji chyby zdrojoveho souboru
+ * @param idIndex sem se ulozi index obsazenych ID
+ * @return true pokud je snapshot platny a data se nacetla, jinak se nic nezmeni
+ */
+bool LoadSnapshot(const string &path, const MappedFile &source, uint64_t hash, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	MappedFile snapshot;
+	if (!MapFile(path, snapshot))
+		return false;
+
+	const char *position = snapshot.data;
+	const char *end = snapshot.data + snapshot.size;
+	auto read = [&position, end](void *target, size_t length)
+	{
+		if ((size_t)(end - position) < length)
+			return false;
+		memcpy(target, position, length);
+		position += length;
+		return true;
+	};
+	auto readText = [&read](string &text)
+	{
+		uint32_t length;
+		if (!read(&length, sizeof(length)))
+			return false;
+		text.resize(length);
+		return read(&text[0], length);
+	};
+
+	SnapshotHeader header;
+	bool ok = snapshot.data != nullptr && read(&header, sizeof(header))
+		&& memcmp(header.magic, "UCETSNAP", 8) == 0 && header.version == SNAPSHOT_VERSION
+		&& header.recordSize == sizeof(UcetniData) && header.sourceSize == source.size
+		&& header.sourceMtime == source.mtime && header.sourceHash == hash
+		&& header.recordCount <= (size_t)(end - position) / sizeof(UcetniData);
+
+	// typ, priznak castky a datum se kontroluji jako kod chyby, bool se cte jako bajt (jina hodnota nez 0 a 1 je UB)
+	auto validRecord = [](const UcetniData &zaznam)
+	{
+		uint8_t castkaPlatna;
+		memcpy(&castkaPlatna, (const char*)&zaznam + offsetof(UcetniData, castkaPlatna), 1);
+		if (zaznam.prijemVydaj > TYP_VYDAJ || castkaPlatna > 1)
+			return false;
+		if (zaznam.datum == 0)
+			return true;
+		int rok = DateYear(zaznam.datum), mesic = DateMonth(zaznam.datum);
+		return rok >= 1582 && rok <= 9999 && mesic >= 1 && mesic <= 12
+			&& DateDay(zaznam.datum) >= 1 && DateDay(zaznam.datum) <= DAYS_IN_MONTH[IsLeapYear(rok)][mesic];
+	};
+
+	vector<UcetniData> records;
+	vector<uint8_t> used(MAX_ID + 1);
+	vector<ErrorEntry> errors;
+	vector<string> names;
+	if (ok)
+	{
+		records.resize(header.recordCount);
+		ok = read(records.data(), records.size() * sizeof(UcetniData)) && read(used.data(), used.size())
+			&& header.errorCount <= (size_t)(end - position) / sizeof(ErrorEntry);
+		for (size_t i = 0; ok && i < records.size(); i++)
+			ok = validRecord(records[i]);
+	}
+	if (ok)
+	{
+		errors.resize(header.errorCount);
+		ok = read(errors.data(), errors.size() * sizeof(ErrorEntry));
+		for (size_t i = 0; ok && i < errors.size(); i++)
+			ok = errors[i].code < ERROR_CODE_COUNT;
+	}
+	for (size_t i = 0; ok && i < header.categoryCount; i++)
+	{
+		names.emplace_back();
+		ok = readText(names.back());
+	}
+	for (size_t i = 0; ok && i < records.size(); i++)
+		ok = records[i].kategorie < names.size();
+	UnmapFile(snapshot);
+	if (!ok)
+		return false;
+
+	// slovnik kategorii se meni az u platneho snapshotu, jinak by v nem zustaly kategorie odmitnutych dat
+	vector<uint32_t> kategorie;
+	kategorie.reserve(names.size());
+	for (const string &name : names)
+		kategorie.push_back(InternCategory(name, categories));
+	for (UcetniData &zaznam : records)
+		zaznam.kategorie = kategorie[zaznam.kategorie];
+
+	values.swap(records);
+	errorLog.entries.insert(errorLog.entries.end(), errors.begin(), errors.end());
+	for (const ErrorEntry &error : errors)
+		errorLog.counts[error.code]++;
+	errorLog.line = header.lineCount;
+	idIndex = IdIndex();
+	for (int id = 0; id <= MAX_ID; id++)
+	{
+		if (used[id])
+			idIndex.used.set(id);
+	}
+	idIndex.invalidUsed = header.invalidUsed != 0;
+	return true;
+}
+
+/**
+ * @brief Funkce zapise snapshot nactenych dat, zapisuje se do docasneho souboru, ktery se pak prejmenuje
+ * @param path cesta ke snapshotu
+ * @param source namapovany zdrojovy .csv soubor
+ * @param hash hash obsahu zdrojoveho souboru
+ * @param values nactene zaznamy
+ * @param errorLog struktura s chybami
+ * @param firstError index prvni chyby zdrojoveho souboru v errorLog
+ * @param lines pocet radku zdrojoveho souboru
+ * @param idIndex index obsazenych ID
+ * @return true pokud se snapshot podarilo zapsat
+ */
+bool SaveSnapshot(const string &path, const MappedFile &source, uint64_t hash, const vector<UcetniData> &values, const ErrorLog &errorLog, size_t firstError, uint32_t lines, const IdIndex &idIndex)
+{
+	uint32_t categoryCount = 0;		// ulozi se nazvy kategorii 0 .. nejvyssi pouzite ID
+	for (const UcetniData &zaznam : values)
+		categoryCount = max(categoryCount, zaznam.kategorie + 1);
+
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "UCETSNAP", 8);
+	header.version = SNAPSHOT_VERSION;
+	header.recordSize = sizeof(UcetniData);
+	header.sourceSize = source.size;
+	header.sourceMtime = source.mtime;
+	header.sourceHash = hash;
+	header.recordCount = values.size();
+	header.errorCount = errorLog.entries.size() - firstError;
+	header.categoryCount = categoryCount;
+	header.invalidUsed = idIndex.invalidUsed;
+	header.lineCount = lines;
+
+	vector<uint8_t> used(MAX_ID + 1);
+	for (int id = 0; id <= MAX_ID; id++)
+		used[id] = idIndex.used.test(id);
+	vector<ErrorEntry> errors(errorLog.entries.size() - firstError);
+	memset(errors.data(), 0, errors.size() * sizeof(ErrorEntry));		// bez nahodnych bajtu vyplne ve snapshotu
+	for (size_t i = 0; i < errors.size(); i++)
+	{
+		errors[i].id = errorLog.entries[firstError + i].id;
+		errors[i].line = errorLog.entries[firstError + i].line;
+		errors[i].code = errorLog.entries[firstError + i].code;
+	}
+
+	string tmpPath = path + ".tmp";
+	FILE *file = fopen(tmpPath.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	auto writeText = [file](const string &text)
+	{
+		uint32_t length = text.size();
+		return fwrite(&length, sizeof(length), 1, file) == 1 && fwrite(text.data(), 1, length, file) == length;
+	};
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(values.data(), sizeof(UcetniData), values.size(), file) == values.size()
+		&& fwrite(used.data(), 1, used.size(), file) == used.size()
+		&& fwrite(errors.data(), sizeof(ErrorEntry), errors.size(), file) == errors.size();
+	for (uint32_t i = 0; ok && i < categoryCount; i++)
+		ok = writeText(CategoryText(i));
+	if (fclose(file) != 0)
+		ok = false;
+
+	if (ok)
+	{
+#ifdef _WIN32
+		ok = MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+		ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+	}
+	if (!ok)
+		remove(tmpPath.c_str());
+	return ok;
+}
+
+/**
+ * @brief Funkce namapuje soubor do pameti jen pro cteni
+ * @param path cesta k souboru
+ * @param file struktura, do ktere se ulozi namapovany obsah
+ * @return true pokud se soubor podarilo otevrit, false pokud ne
+ */
+bool MapFile(const string &path, MappedFile &file)
+{
+	file = MappedFile();
+#ifdef _WIN32
+	file.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file.file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file.file, &size))
+	{
+		UnmapFile(file);
+		return false;
+	}
+	file.size = (size_t)size.QuadPart;
+	FILETIME writeTime;
+	if (GetFileTime(file.file, nullptr, nullptr, &writeTime))
+		file.mtime = ((int64_t)writeTime.dwHighDateTime << 32) | writeTime.dwLowDateTime;
+	if (file.size == 0)
+		return true;		// prazdny soubor nelze namapovat, data zustanou nullptr
+
+	file.mapping = CreateFileMappingA(file.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (file.mapping != nullptr)
+		file.data = (const char*)MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file.data == nullptr)
+	{
+		UnmapFile(file);
+		return false;
+	}
+#else
+	file.fd = open(path.c_str(), O_RDONLY);
+	if (file.fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(file.fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		UnmapFile(file);
+		return false;
+	}
+	file.size = (size_t)st.st_size;
+	file.mtime = (int64_t)st.st_mtime;
+	if (file.size == 0)
+		return true;		// prazdny soubor nelze namapovat, data zustanou nullptr
+
+	void *mapped = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		UnmapFile(file);
+		return false;
+	}
+	madvise(mapped, file.size, MADV_SEQUENTIAL);	// soubor se cte jednou od zacatku do konce
+	file.data = (const char*)mapped;
+#endif
+	return true;
+}
+
+/**
+ * @brief Funkce zrusi mapovani souboru a zavre ho
+ * @param file namapovany soubor
+ */
+void UnmapFile(MappedFile &file)
+{
+#ifdef _WIN32
+	if (file.data != nullptr)
+		UnmapViewOfFile(file.data);
+	if (file.mapping != nullptr)
+		CloseHandle(file.mapping);
+	if (file.file != INVALID_HANDLE_VALUE)
+		CloseHandle(file.file);
+#else
+	if (file.data != nullptr)
+		munmap((void*)file.data, file.size);
+	if (file.fd >= 0)
+		close(file.fd);
+#endif
+	file = MappedFile();
+}
+
+/**
+ * @brief Funkce rozdeli buffer s obsahem .csv souboru na radky a pole a ulozi je do ucetnich dat
+ *
+ * Pole se nekopiruji, kazde pole je jen string_view do bufferu. Prazdne pole se bere jako " "
+ * (stejne jako driv, kdy se mezera vkladala do radku), radky s mene nez 4 oddelovaci se preskakuji
+ * a koncove '\r' u radku se ignoruje.
+ * @param buffer obsah souboru
+ * @param length delka obsahu v bajtech
+ * @param values ucetni data, kam se pridavaji nactene radky
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, pridavaji se do nej ID nactenych radku
+ */
+void ParseCsvBuffer(const char *buffer, size_t length, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	vector<string_view> fields;
+	CsvScanner scanner;
+	CsvScannerInit(scanner, buffer, buffer + length);
+
+	size_t lines = 0;
+	PhaseTotals totals;
+
+	//go through every line
+	while (scanner.position < scanner.end)
+	{
+		{
+			StatsTimer timer(PHASE_TOKENIZE, totals);
+			NextCsvRecord(scanner, fields);
+		}
+		lines++;
+		errorLog.line++;
+		if (fields.size() < 5)				// detekce, jestli nejsou na radku 4 oddelovace poli, tak preskoci radek
+			continue;
+
+		ParseCsvFields(fields, values, errorLog, idIndex, totals);
+	}
+	StatsMerge(totals);
+	StatsCount(PHASE_TOKENIZE, lines, length);
+}
+
+/**
+ * @brief Funkce nacte buffer s obsahem .csv souboru nekolika vlakny, vysledek je stejny jako u ParseCsvBuffer
+ *
+ * Buffer se rozdeli na hranicich radku na CHUNKS_PER_THREAD casti na vlakno, vlakna si berou casti
+ * postupne (ParseCsvChunk). Casti se pak slouci v poradi souboru jednim vlaknem (MergeCsvChunk),
+ * takze duplicitni ID vyhrava prvni vyskyt a chyby zustanou v poradi souboru.
+ * @param buffer obsah souboru
+ * @param length delka obsahu v bajtech
+ * @param threads pocet vlaken
+ * @param values ucetni data, kam se pridavaji nactene radky
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, pridavaji se do nej ID nactenych radku
+ */
+void ParseCsvParallel(const char *buffer, size_t length, unsigned int threads, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	const char *end = buffer + length;
+	size_t chunkCount = (size_t)threads * CHUNKS_PER_THREAD;
+	vector<CsvChunk> chunks;
+	chunks.reserve(chunkCount);
+
+	const char *begin = buffer;
+	for (size_t i = 1; i <= chunkCount && begin < end; i++)
+	{
+		const char *chunkEnd = (i == chunkCount ? end : max(begin, buffer + length / chunkCount * i));
+		const char *newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+		chunkEnd = (newline == nullptr ? end : newline + 1);		// cast konci vzdy za celym radkem
+
+		chunks.emplace_back();
+		chunks.back().begin = begin;
+		chunks.back().end = chunkEnd;
+		begin = chunkEnd;
+	}
+
+	atomic<size_t> nextChunk(0);
+	auto worker = [&chunks, &nextChunk]()
+	{
+		for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+			ParseCsvChunk(chunks[i]);
+	};
+
+	vector<thread> pool;
+	for (unsigned int t = 1; t < threads && t < chunks.size(); t++)
+		pool.emplace_back(worker);
+	worker();			// hlavni vlakno pracuje taky
+	for (thread &t : pool)
+		t.join();
+
+	size_t total = values.size();
+	for (const CsvChunk &chunk : chunks)
+		total += chunk.values.size();
+	values.reserve(total);
+
+	for (CsvChunk &chunk : chunks)
+	{
+		MergeCsvChunk(chunk, values, errorLog, idIndex);
+		chunk = CsvChunk();		// uvolneni pameti casti hned po slouceni
+	}
+}
+
+/**
+ * @brief Funkce zpracuje jednu cast souboru, vola se z vlaken paralelniho nacitani
+ *
+ * Nesaha na zadny sdileny stav: ID se kontroluje jen na rozsah (duplicity resi MergeCsvChunk),
+ * kategorie jdou do lokalniho slovniku casti a chyby do errorLog casti.
+ * @param chunk cast souboru, vysledky se ulozi do ni
+ */
+void ParseCsvChunk(CsvChunk &chunk)
+{
+	static const IdIndex noIds;		// prazdny index, IsValidID tak hlasi jen chyby rozsahu
+	vector<string_view> fields;
+	CsvScanner scanner;
+	CsvScannerInit(scanner, chunk.begin, chunk.end);
+	size_t lines = 0;
+	PhaseTotals totals;		// casy poli se sectou lokalne a prictou jednou za cast
+
+	while (scanner.position < scanner.end)
+	{
+		string_view line;
+		{
+			StatsTimer timer(PHASE_TOKENIZE, totals);
+			line = NextCsvRecord(scanner, fields);
+		}
+		lines++;
+		chunk.errorLog.line++;
+		if (fields.size() < 5)				// detekce, jestli nejsou na radku 4 oddelovace poli, tak preskoci radek
+			continue;
+
+		uint32_t row = chunk.values.size();
+		chunk.values.push_back(UcetniData());
+		if (fields.size() > 5)
+		{
+			chunk.slowRows.push_back(row);
+			chunk.slowLines.push_back(line);
+			chunk.slowLineNumbers.push_back(chunk.errorLog.line);
+			continue;
+		}
+
+		UcetniData &zaznam = chunk.values[row];
+		int id;
+		{
+			StatsTimer timer(PHASE_VALIDATE_ID, totals);
+			zaznam.ID = IsValidID(fields[0], noIds, chunk.errorLog, id) ? id : -1;
+		}
+		zaznam.prijemVydaj = CheckIncomeExpenditure(fields[1]);
+		zaznam.kategorie = InternCategory(fields[2], chunk.kategorie);
+		{
+			StatsTimer timer(PHASE_VALIDATE_MONEY, totals);
+			zaznam.castkaPlatna = CheckMoney(fields[3], chunk.errorLog, zaznam.ID, zaznam.castka);
+		}
+		{
+			StatsTimer timer(PHASE_VALIDATE_DATE, totals);
+			TimeFormat(fields[4], row, chunk.errorLog, zaznam.ID, chunk.values);
+		}
+		chunk.errorRows.resize(chunk.errorLog.entries.size(), row);
+	}
+	StatsMerge(totals);
+	StatsCount(PHASE_TOKENIZE, lines, chunk.end - chunk.begin);
+}
+
+/**
+ * @brief Funkce prida zpracovanou cast souboru do ucetnich dat, casti se slucuji v poradi souboru
+ *
+ * Tady se resi duplicitni ID (prvni vyskyt vyhrava, stejne jako u ParseCsvBuffer), lokalni kategorie
+ * se prevedou do globalniho slovniku v poradi prvniho vyskytu a radky s vice nez 5 poli se zpracuji
+ * stejne jako v ParseCsvBuffer.
+ * @param chunk zpracovana cast souboru
+ * @param values ucetni data, kam se pridavaji zaznamy casti
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID
+ */
+void MergeCsvChunk(CsvChunk &chunk, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex)
+{
+	vector<uint32_t> kategorie(chunk.kategorie.names.size(), UINT32_MAX);	// lokalni ID -> globalni ID
+	vector<string_view> fields;
+	uint32_t firstLine = errorLog.line;		// cisla radku casti jsou od jejiho zacatku
+	size_t error = 0;
+	size_t slow = 0;
+	PhaseTotals totals;
+
+	for (uint32_t row = 0; row < chunk.values.size(); row++)
+	{
+		if (slow < chunk.slowRows.size() && chunk.slowRows[slow] == row)
+		{
+			errorLog.line = firstLine + chunk.slowLineNumbers[slow];
+			SplitCsvFields(chunk.slowLines[slow++], fields);
+			ParseCsvFields(fields, values, errorLog, idIndex, totals);
+			continue;
+		}
+
+		UcetniData zaznam = chunk.values[row];
+		int candidate = zaznam.ID;
+		if (IsIdDuplicated(zaznam.ID, idIndex))
+			zaznam.ID = -1;
+		RegisterId(zaznam.ID, idIndex);
+
+		if (kategorie[zaznam.kategorie] == UINT32_MAX)
+			kategorie[zaznam.kategorie] = InternCategory(chunk.kategorie.names[zaznam.kategorie], categories);
+		zaznam.kategorie = kategorie[zaznam.kategorie];
+
+		// chyby castky a datumu se zapsaly s kandidatem ID, u duplicity ma ale zaznam ID -1
+		for (; error < chunk.errorRows.size() && chunk.errorRows[error] == row; error++)
+		{
+			ErrorEntry entry = chunk.errorLog.entries[error];
+			if (entry.id == candidate)
+				entry.id = zaznam.ID;
+			entry.line += firstLine;
+			errorLog.entries.push_back(entry);
+			errorLog.counts[entry.code]++;
+		}
+		values.push_back(zaznam);
+	}
+	errorLog.line = firstLine + chunk.errorLog.line;
+	StatsMerge(totals);
+}
+
+/**
+ * @brief Funkce vrati dalsi radek bufferu bez '\n' a koncoveho '\r' a posune pozici za nej
+ * @param position pozice v bufferu, posune se na zacatek dalsiho radku
+ * @param end konec bufferu
+ * @return radek
+ */
+string_view NextCsvLine(const char *&position, const char *end)
+{
+	const char *lineStart = position;
+	const char *lineEnd = (const char*)memchr(lineStart, '\n', end - lineStart);
+	position = (lineEnd == nullptr ? end : lineEnd + 1);
+	if (lineEnd == nullptr)
+		lineEnd = end;
+	if (lineEnd > lineStart && lineEnd[-1] == '\r')
+		lineEnd--;
+	return string_view(lineStart, lineEnd - lineStart);
+}
+
+/**
+ * @brief Funkce rozdeli radek na pole podle DELIMITER, prazdne pole se bere jako " "
+ * @param line radek
+ * @param fields sem se ulozi pole radku
+ */
+void SplitCsvFields(string_view line, vector<string_view> &fields)
+{
+	static const string_view emptyField = " ";
+	fields.clear();
+	size_t fieldStart = 0;
+	for (size_t c = 0; c < line.size(); c++)
+	{
+		if (line[c] == DELIMITER)
+		{
+			fields.push_back(c == fieldStart ? emptyField : line.substr(fieldStart, c - fieldStart));
+			fieldStart = c + 1;
+		}
+	}
+	fields.push_back(line.size() == fieldStart ? emptyField : line.substr(fieldStart));
+}
+
+/**
+ * @brief Funkce pripravi CsvScanner na zacatek bufferu
+ * @param scanner scanner
+ * @param begin zacatek bufferu
+ * @param end konec bufferu
+ */
+void CsvScannerInit(CsvScanner &scanner, const char *begin, const char *end)
+{
+	scanner.position = begin;
+	scanner.end = end;
+	scanner.block = begin;
+	scanner.mask = (begin < end ? CsvBlockMaskTail(begin, end) : 0);
+}
+
+/**
+ * @brief Funkce vrati dalsi radek bufferu a jeho pole, vysledek je stejny jako NextCsvLine a SplitCsvFields
+ * @param scanner scanner, posune se na zacatek dalsiho radku
+ * @param fields sem se ulozi pole radku, prazdne pole se bere jako " "
+ * @return radek bez '\n' a koncoveho '\r'
+ */
+string_view NextCsvRecord(CsvScanner &scanner, vector<string_view> &fields)
+{
+	static const string_view emptyField = " ";
+	fields.clear();
+	const char *lineStart = scanner.position;
+	const char *fieldStart = lineStart;
+	const char *lineEnd = scanner.end;
+
+	for (;;)
+	{
+		while (scanner.mask == 0)
+		{
+			scanner.block += 64;
+			if (scanner.block >= scanner.end)
+				break;
+			scanner.mask = CsvBlockMaskTail(scanner.block, scanner.end);
+		}
+		if (scanner.mask == 0)
+			break;		// posledni radek bez '\n'
+
+#ifdef __GNUC__
+		const char *found = scanner.block + __builtin_ctzll(scanner.mask);
+#else
+		int bit = 0;
+		while (!(scanner.mask >> bit & 1))
+			bit++;
+		const char *found = scanner.block + bit;
+#endif
+		scanner.mask &= scanner.mask - 1;
+		if (*found == '\n')
+		{
+			lineEnd = found;
+			break;
+		}
+		fields.push_back(found == fieldStart ? emptyField : string_view(fieldStart, found - fieldStart));
+		fieldStart = found + 1;
+	}
+
+	scanner.position = (lineEnd == scanner.end ? scanner.end : lineEnd + 1);
+	if (lineEnd > fieldStart && lineEnd[-1] == '\r')
+		lineEnd--;
+	fields.push_back(lineEnd == fieldStart ? emptyField : string_view(fieldStart, lineEnd - fieldStart));
+	return string_view(lineStart, lineEnd - lineStart);
+}
+
+/**
+ * @brief Funkce spocita masku pozic DELIMITER a '\n' bloku, ktery muze byt kratsi nez 64 bajtu
+ * @param block zacatek bloku
+ * @param end konec bufferu
+ * @return maska, bit i je nastaveny pokud block[i] je DELIMITER nebo '\n'
+ */
+uint64_t CsvBlockMaskTail(const char *block, const char *end)
+{
+	if (end - block >= 64)
+		return csvBlockMask(block);
+
+	char tail[64] = { 0 };		// za koncem bufferu se nesmi cist
+	memcpy(tail, block, end - block);
+	return csvBlockMask(tail);
+}
+
+/**
+ * @brief Funkce spocita masku pozic DELIMITER a '\n' v 64 bajtech po jednom bajtu
+ * @param block 64 bajtu
+ * @return maska, bit i je nastaveny pokud block[i] je DELIMITER nebo '\n'
+ */
+uint64_t CsvBlockMaskScalar(const char *block)
+{
+	uint64_t mask = 0;
+	for (int i = 0; i < 64; i++)
+		mask |= (uint64_t)(block[i] == DELIMITER || block[i] == '\n') << i;
+	return mask;
+}
+
+#ifdef CSV_SIMD
+/**
+ * @brief Funkce spocita masku pozic DELIMITER a '\n' v 64 bajtech po 16 bajtech (SSE2)
+ * @param block 64 bajtu
+ * @return maska, bit i je nastaveny pokud block[i] je DELIMITER nebo '\n'
+ */
+__attribute__((target("sse2")))
+uint64_t CsvBlockMaskSse2(const char *block)
+{
+	const __m128i delimiter = _mm_set1_epi8(DELIMITER);
+	const __m128i newline = _mm_set1_epi8('\n');
+	uint64_t mask = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+		__m128i found = _mm_or_si128(_mm_cmpeq_epi8(bytes, delimiter), _mm_cmpeq_epi8(bytes, newline));
+		mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(found) << (16 * i);
+	}
+	return mask;
+}
+
+/**
+ * @brief Funkce spocita masku pozic DELIMITER a '\n' v 64 bajtech po 32 bajtech (AVX2)
+ * @param block 64 bajtu
+ * @return maska, bit i je nastaveny pokud block[i] je DELIMITER nebo '\n'
+ */
+__attribute__((target("avx2")))
+uint64_t CsvBlockMaskAvx2(const char *block)
+{
+	const __m256i delimiter = _mm256_set1_epi8(DELIMITER);
+	const __m256i newline = _mm256_set1_epi8('\n');
+	__m256i low = _mm256_loadu_si256((const __m256i*)block);
+	__m256i high = _mm256_loadu_si256((const __m256i*)(block + 32));
+	uint32_t lowMask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(low, delimiter), _mm256_cmpeq_epi8(low, newline)));
+	uint32_t highMask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(high, delimiter), _mm256_cmpeq_epi8(high, newline)));
+	return (uint64_t)highMask << 32 | lowMask;
+}
+#endif
+
+/**
+ * @brief Funkce vybere nejrychlejsi variantu masky oddelovacu, kterou procesor podporuje
+ * @return funkce pro csvBlockMask
+ */
+CsvBlockMaskFunction SelectCsvBlockMask()
+{
+#ifdef CSV_SIMD
+	__builtin_cpu_init();		// vola se pri inicializaci globalnich promennych
+	if (__builtin_cpu_supports("avx2"))
+		return CsvBlockMaskAvx2;
+	if (__builtin_cpu_supports("sse2"))
+		return CsvBlockMaskSse2;
+#endif
+	return CsvBlockMaskScalar;
+}
+
+/**
+ * @brief Funkce zpracuje pole jednoho radku a prida zaznam do ucetnich dat
+ * @param fields pole radku, alespon 5
+ * @param values ucetni data, kam se prida zaznam
+ * @param errorLog struktura, pro ukladani chyb ze vstupu
+ * @param idIndex index obsazenych ID, prida se do nej ID zaznamu
+ * @param totals lokalni soucty casu kontrol, volajici je pricte do statistik (StatsMerge)
+ */
+void ParseCsvFields(const vector<string_view> &fields, vector<UcetniData> &values, ErrorLog &errorLog, IdIndex &idIndex, PhaseTotals &totals)
+{
+	unsigned int overallRows = values.size();
+	values.push_back(UcetniData());		// add row to 'values'
+
+	for (unsigned int n = 0; n < fields.size(); n++)
+	{
+		string_view field = fields[n];
+		unsigned int count = n % 5;		// kazde dalsi pole nad 5 se zpracuje znovu jako ID, typ, ...
+		int id;
+
+		switch (count)
+		{
+		case 0:
+		{
+			StatsTimer timer(PHASE_VALIDATE_ID, totals);
+			values[overallRows].ID = IsValidID(field, idIndex, errorLog, id) ? id : -1;
+			RegisterId(values[overallRows].ID, idIndex);
+			break;
+		}
+		case 1: values[overallRows].prijemVydaj = CheckIncomeExpenditure(field); break;
+		case 2: values[overallRows].kategorie = InternCategory(field, categories); break;
+		case 3:
+		{
+			StatsTimer timer(PHASE_VALIDATE_MONEY, totals);
+			values[overallRows].castkaPlatna = CheckMoney(field, errorLog, values[overallRows].ID, values[overallRows].castka);
+			break;
+		}
+		case 4:
+		{
+			StatsTimer timer(PHASE_VALIDATE_DATE, totals);
+			TimeFormat(field, overallRows, errorLog, values[overallRows].ID, values);	// check for correct time
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Funkce vrati pocet vlaken pro nacitani dat podle nastaveni LOAD_THREADS
+ * @return pocet vlaken, alespon 1
+ */
+unsigned int LoadThreadCount()
+{
+	if (LOAD_THREADS != 0)
+		return LOAD_THREADS;
+	return max(1u, thread::hardware_concurrency());
+}
+
+/**
+ * @brief Funkce doplni index dotazu o zaznamy pridane od minuleho dotazu (AddData, AppendData)
+ *
+ * Nove zaznamy maji vetsi indexy nez vsechny zaindexovane, takze se jen pripisou na konec seznamu
+ * kategorii a typu. Datumovy index se doplni serazenymi novymi klici a slouci (inplace_merge).
+ * @param data ucetni data
+ */
+void UpdateQueryIndex(const vector<UcetniData> &data)
+{
+	if (data.size() < queryIndex.records)
+		queryIndex = QueryIndex();		// data se nahradila jinymi
+	if (data.size() == queryIndex.records)
+		return;
+
+	size_t dated = queryIndex.byDate.size();
+	for (size_t i = queryIndex.records; i < data.size(); i++)
+	{
+		const UcetniData &zaznam = data[i];
+		if (zaznam.datum != 0)
+			queryIndex.byDate.push_back((uint64_t)zaznam.datum << 32 | i);
+		if (zaznam.kategorie >= queryIndex.byCategory.size())
+			queryIndex.byCategory.resize(zaznam.kategorie + 1);
+		queryIndex.byCategory[zaznam.kategorie].push_back(i);
+		queryIndex.byType[zaznam.prijemVydaj].push_back(i);
+	}
+	sort(queryIndex.byDate.begin() + dated, queryIndex.byDate.end());
+	inplace_merge(queryIndex.byDate.begin(), queryIndex.byDate.begin() + dated, queryIndex.byDate.end());
+	queryIndex.records = data.size();
+}
+
+/**
+ * @brief Funkce najde zaznamy, ktere odpovidaji dotazu
+ *
+ * Datum se hleda binarne v datumovem indexu. Jako zaklad vysledku se vezme nejmensi z rozsahu datumu,
+ * seznamu kategorie a seznamu typu, ostatni seznamy se s nim pruniknou (IntersectPostings).
+ * @param data ucetni data
+ * @param query dotaz
+ * @return indexy odpovidajicich zaznamu v poradi souboru
+ */
+vector<uint32_t> RunQuery(const vector<UcetniData> &data, const Query &query)
+{
+	static const vector<uint32_t> noRecords;
+	UpdateQueryIndex(data);
+
+	vector<const vector<uint32_t>*> lists;
+	if (query.typ >= 0)
+		lists.push_back(&queryIndex.byType[query.typ]);
+	if (query.kategorie >= 0)
+		lists.push_back(query.kategorie < (int64_t)queryIndex.byCategory.size() ? &queryIndex.byCategory[query.kategorie] : &noRecords);
+	sort(lists.begin(), lists.end(), [](const vector<uint32_t> *a, const vector<uint32_t> *b) { return a->size() < b->size(); });
+
+	vector<uint32_t> result;
+	bool dated = (query.od != 0 || query.doDatum != UINT32_MAX);
+	auto first = lower_bound(queryIndex.byDate.begin(), queryIndex.byDate.end(), (uint64_t)query.od << 32);
+	auto last = upper_bound(first, queryIndex.byDate.end(), (uint64_t)query.doDatum << 32 | UINT32_MAX);
+	if (dated && (lists.empty() || (size_t)(last - first) <= lists[0]->size()))
+	{
+		for (auto it = first; it != last; ++it)
+			result.push_back((uint32_t)*it);
+		sort(result.begin(), result.end());
+	}
+	else if (!lists.empty())
+	{
+		for (uint32_t i : *lists[0])
+		{
+			if (!dated || (data[i].datum != 0 && data[i].datum >= query.od && data[i].datum <= query.doDatum))
+				result.push_back(i);
+		}
+		lists.erase(lists.begin());
+	}
+	else
+	{
+		result.resize(data.size());
+		for (size_t i = 0; i < result.size(); i++)
+			result[i] = i;
+	}
+
+	for (const vector<uint32_t> *list : lists)
+		result = IntersectPostings(result, *list);
+	return result;
+}
+
+/**
+ * @brief Funkce vrati prunik dvou vzestupnych seznamu indexu
+ *
+ * Prochazi se kratsi seznam a v delsim se dalsi prvek hleda exponencialne od posledni pozice,
+ * takze pri velmi rozdilnych delkach se vetsina delsiho seznamu preskoci.
+ * @param a vzestupny seznam
+ * @param b vzestupny seznam
+ * @return prunik, vzestupne
+ */
+vector<uint32_t> IntersectPostings(const vector<uint32_t> &a, const vector<uint32_t> &b)
+{
+	const vector<uint32_t> &small = (a.size() <= b.size() ? a : b);
+	const vector<uint32_t> &large = (a.size() <= b.size() ? b : a);
+	vector<uint32_t> result;
+	size_t position = 0;
+	for (uint32_t value : small)
+	{
+		size_t step = 1;
+		size_t bound = position;
+		while (bound < large.size() && large[bound] < value)
+		{
+			position = bound + 1;
+			bound += step;
+			step *= 2;
+		}
+		position = lower_bound(large.begin() + position, large.begin() + min(bound, large.size()), value) - large.begin();
+		if (position == large.size())
+			break;
+		if (large[position] == value)
+			result.push_back(value);
+	}
+	return result;
+}
+
+/**
+ * @brief Funkce najde ID kategorie podle nazvu (bez ohledu na velikost pismen a okrajove mezery), slovnik se nemeni
+ * @param name nazev kategorie
+ * @param id sem se ulozi ID kategorie
+ * @return true pokud kategorie existuje
+ */
+bool FindCategory(string_view name, uint32_t &id)
+{
+	name = TrimCategory(name);
+	string key(name);
+	for (char &c : key)
+		c = tolower((unsigned char)c);
+
+	auto it = categories.ids.find(key);
+	if (it == categories.ids.end())
+		return false;
+	id = it->second;
+	return true;
+}
+
+/**
+ * @brief Funkce se zepta na dotaz (rozsah datumu, typ, kategorie) a vypise odpovidajici zaznamy do konzole, nebo do html
+ * @param ucetniData ucetni data
+ */
+void QueryData(const vector<UcetniData> &ucetniData)
+{
+	Query query;
+	string text;
+	ErrorCode error;
+
+	cout << "Zadejte datum od (D.M.RRRR, \"-\" - bez omezeni):" << endl;
+	cin >> text;
+	if (text != "-" && (query.od = ParseDate(text, error)) == 0)
+	{
+		cout << "Neplatne datum." << endl << endl;
+		return;
+	}
+	cout << "Zadejte datum do (D.M.RRRR, \"-\" - bez omezeni):" << endl;
+	cin >> text;
+	if (text != "-" && (query.doDatum = ParseDate(text, error)) == 0)
+	{
+		cout << "Neplatne datum." << endl << endl;
+		return;
+	}
+
+	int d = 3;
+	cout << "Vyberte typ:" << endl;
+	cout << "1 - prijem\n2 - vydaj\n3 - vse" << endl;
+	cin >> d;
+	if (cin.fail())
+	{
+		d = 3;
+		cin.clear();
+	}
+	if (d == 1)
+		query.typ = TYP_PRIJEM;
+	else if (d == 2)
+		query.typ = TYP_VYDAJ;
+
+	cout << "Zadejte kategorii (prazdny radek - vsechny kategorie):" << endl;
+	cin.ignore(1000000, '\n');
+	getline(cin, text);
+	uint32_t kategorie;
+	if (!TrimCategory(text).empty())
+		query.kategorie = (FindCategory(text, kategorie) ? (int64_t)kategorie : (int64_t)categories.names.size());	// neznama kategorie nema zadne zaznamy
+
+	vector<uint32_t> found = RunQuery(ucetniData, query);
+	vector<UcetniData> result;
+	result.reserve(found.size());
+	for (uint32_t i : found)
+		result.push_back(ucetniData[i]);
+
+	cout << "Vyberte vystup:" << endl;
+	cout << "1 - tabulka do konzole\n2 - html soubor " << OutputSiblingPath("_dotaz.html") << endl;
+	cin >> d;
+	if (cin.fail())
+	{
+		d = 1;
+		cin.clear();
+		cin.ignore(1000000, '\n');
+	}
+	cout << endl;
+	if (d == 2)
+	{
+		string path = OutputSiblingPath("_dotaz.html");
+		if (CreateHtmlReport(result, path))
+			cout << "Vysledek dotazu zapsan do souboru " << path << endl;
+	}
+	else
+		printTable(result);
+	cout << "Nalezeno zaznamu: " << result.size() << " z " << ucetniData.size() << endl << endl;
+}
+
+/**
+ * @brief Funkce zapocita do indexu zustatku zaznamy pridane od minuleho pouziti (AddData, AppendData)
+ *
+ * Kazdy novy zaznam je jedno pricteni ke svemu dni v O(log n) (BalanceAdd). Prazdny index se naplni
+ * najednou: strom se zvetsi jednou podle nejpozdejsiho dne, castky se sectou do dnu a strom se pak
+ * sestavi v O(n) (BuildBalanceTree).
+ * @param data ucetni data
+ */
+void UpdateBalanceIndex(const vector<UcetniData> &data)
+{
+	if (data.size() < balanceIndex.records)
+		balanceIndex = BalanceIndex();		// data se nahradila jinymi
+	if (data.size() == balanceIndex.records)
+		return;
+
+	bool build = balanceIndex.records == 0;
+	if (build)
+	{
+		// zvetseni stromu (BalanceReserve) kopiruje uzly hotoveho stromu, soucty dnu by zdvojilo
+		uint32_t lastDay = 0;
+		for (const UcetniData &zaznam : data)
+		{
+			if (IsReportable(zaznam))
+				lastDay = max(lastDay, DayNumber(zaznam.datum));
+		}
+		BalanceReserve(lastDay);
+	}
+	for (size_t i = balanceIndex.records; i < data.size(); i++)
+	{
+		const UcetniData &zaznam = data[i];
+		if (!IsReportable(zaznam))
+			continue;
+		uint32_t day = DayNumber(zaznam.datum);
+		int64_t delta = (zaznam.prijemVydaj == TYP_PRIJEM ? zaznam.castka : -zaznam.castka);
+		if (build)
+			balanceIndex.tree[day] += delta;		// zatim jen soucty dnu, strom az v BuildBalanceTree
+		else
+		{
+			BalanceReserve(day);
+			BalanceAdd(day, delta);
+		}
+	}
+	balanceIndex.records = data.size();
+	if (build)
+		BuildBalanceTree();
+}
+
+/**
+ * @brief Funkce sestavi Fenwickuv strom ze souctu dnu v balanceIndex.tree (na miste) v O(n)
+ */
+void BuildBalanceTree()
+{
+	vector<int64_t> &tree = balanceIndex.tree;
+	size_t n = (tree.empty() ? 0 : tree.size() - 1);
+	for (size_t i = 1; i <= n; i++)
+	{
+		size_t parent = i + (i & (0 - i));
+		if (parent <= n)
+			tree[parent] += tree[i];
+	}
+}
+
+/**
+ * @brief Funkce zvetsi strom indexu zustatku, aby obsahoval den
+ *
+ * Pri zdvojnasobeni velikosti n (mocnina 2) na 2n pokryva novy uzel 2n vsechny dny (stejny soucet
+ * jako uzel n) a ostatni nove uzly jen nove, zatim prazdne dny, takze se nic neprepocitava.
+ * Plati jen pro sestaveny strom, ne pro soucty dnu pred BuildBalanceTree.
+ * @param day cislo dne (DayNumber)
+ */
+void BalanceReserve(uint32_t day)
+{
+	vector<int64_t> &tree = balanceIndex.tree;
+	if (tree.empty())
+		tree.assign(2, 0);
+	while (tree.size() - 1 < day)
+	{
+		size_t n = tree.size() - 1;
+		tree.resize(2 * n + 1, 0);
+		tree[2 * n] = tree[n];
+	}
+}
+
+/**
+ * @brief Funkce pricte castku ke dni v indexu zustatku v O(log n)
+ * @param day cislo dne (DayNumber), strom uz den obsahuje (BalanceReserve)
+ * @param delta prijem (kladny), nebo vydaj (zaporny) v halerich
+ */
+void BalanceAdd(uint32_t day, int64_t delta)
+{
+	for (size_t i = day; i < balanceIndex.tree.size(); i += i & (0 - i))
+		balanceIndex.tree[i] += delta;
+}
+
+/**
+ * @brief Funkce vrati soucet dnu 1 - day indexu zustatku v O(log n)
+ * @param day cislo posledniho dne (DayNumber), muze byt za koncem stromu
+ * @return prijmy - vydaje v halerich
+ */
+int64_t BalancePrefix(uint32_t day)
+{
+	int64_t sum = 0;
+	size_t i = (balanceIndex.tree.empty() ? 0 : min<size_t>(day, balanceIndex.tree.size() - 1));
+	for (; i > 0; i -= i & (0 - i))
+		sum += balanceIndex.tree[i];
+	return sum;
+}
+
+/**
+ * @brief Funkce vrati cislo dne od 1. 1. BALANCE_EPOCH_YEAR (ten den ma cislo 1)
+ *
+ * Den za koncem mesice (napr. 31. 2.) se bere jako posledni den mesice, aby se dal zadat konec mesice.
+ * @param datum datum RRRRMMDD, rok alespon BALANCE_EPOCH_YEAR
+ * @return cislo dne, 0 u neplatneho datumu 0
+ */
+uint32_t DayNumber(uint32_t datum)
+{
+	if (datum == 0)
+		return 0;
+	int rok = DateYear(datum);
+	int mesic = DateMonth(datum);
+	int den = min<int>(DateDay(datum), DAYS_IN_MONTH[IsLeapYear(rok)][mesic]);
+
+	// dny od 1. 3. roku 0, rok zacina breznem, takze prestupny den je az na konci roku
+	auto civilDays = [](int y, int m, int d)
+	{
+		if (m <= 2)
+			y--;
+		return 365 * y + y / 4 - y / 100 + y / 400 + (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	};
+	return (uint32_t)(civilDays(rok, mesic, den) - civilDays(BALANCE_EPOCH_YEAR, 1, 1) + 1);
+}
+
+/**
+ * @brief Funkce vrati zustatek (prijmy - vydaje platnych zaznamu) ke konci dne
+ * @param datum den RRRRMMDD, den nemusi existovat (napr. 31. kazdeho mesice)
+ * @return zustatek v halerich
+ */
+int64_t BalanceUntil(uint32_t datum)
+{
+	return BalancePrefix(DayNumber(datum));
+}
+
+/**
+ * @brief Funkce vrati prijmy - vydaje platnych zaznamu mezi dvema dny vcetne
+ * @param from prvni den RRRRMMDD
+ * @param to posledni den RRRRMMDD
+ * @return prijmy - vydaje v halerich
+ */
+int64_t BalanceBetween(uint32_t from, uint32_t to)
+{
+	if (to < from)
+		return 0;
+	uint32_t before = DayNumber(from);		// neexistujici den (31. 2.) je az za vsemi dny mesice
+	if (DateDay(from) <= DAYS_IN_MONTH[IsLeapYear(DateYear(from))][DateMonth(from)])
+		before--;
+	return BalanceUntil(to) - BalancePrefix(before);
+}
+
+/**
+ * @brief Funkce se zepta na dva dny a vypise zustatek k obema a prijmy - vydaje mezi nimi
+ * @param ucetniData ucetni data
+ */
+void PrintBalance(const vector<UcetniData> &ucetniData)
+{
+	string text;
+	ErrorCode error;
+	uint32_t from, to;
+
+	cout << "Zadejte datum od (D.M.RRRR):" << endl;
+	cin >> text;
+	if ((from = ParseDate(text, error)) == 0)
+	{
+		cout << "Neplatne datum." << endl << endl;
+		return;
+	}
+	cout << "Zadejte datum do (D.M.RRRR):" << endl;
+	cin >> text;
+	if ((to = ParseDate(text, error)) == 0)
+	{
+		cout << "Neplatne datum." << endl << endl;
+		return;
+	}
+
+	UpdateBalanceIndex(ucetniData);
+	MoneyBuffer money;
+	cout << endl;
+	cout << "Zustatek pred " << DateText(from) << ": " << SpacedMoneyValue(BalanceUntil(from) - BalanceBetween(from, from), money) << " Kc" << endl;
+	cout << "Zustatek ke konci " << DateText(to) << ": " << SpacedMoneyValue(BalanceUntil(to), money) << " Kc" << endl;
+	cout << "Prijmy - vydaje od " << DateText(from) << " do " << DateText(to) << ": " << SpacedMoneyValue(BalanceBetween(from, to), money) << " Kc" << endl << endl;
+}
+
+/**
+ * @brief Funkce vypise do konzole, do tabulky data z .csv souboru
+ * @param val vector ucetnich dat
+ */
+void printTable(vector<UcetniData> val)
+{
+	MoneyBuffer money;
+	int widest = 0;
+	for (const UcetniData &zaznam : val)
+		widest = max(widest, zaznam.ID);
+	int idWidth = max(5, (int)to_string(widest).size());		// ID podle souboru (LoadLedgers) jsou delsi
+	string idBorder(idWidth + 1, '_');
+	printf(" %s ________ _________________________ ____________________ ____________\n", idBorder.c_str());
+	printf("|%*s  |  %-5s | %-6s %-16s |%-8s%-12s|   %-9s|\n", idWidth - 1, "ID", "Typ", " ", "Kategorie", " ", "Castka [Kc]", "Datum");
+	printf("|%s+========+=========================+====================+============|\n", string(idWidth + 1, '=').c_str());
+	for (unsigned int i = 0; i < val.size(); i++)
+	{
+		//prinf c-style
+		//If, for some reason, you need to extract the C-style string, you can use the c_str()
+		//method of std::string to get a const char * that is null-terminated. Use it like: myString.c_str()
+		string date = DateText(val[i].datum);
+		printf("|%*i | %-6s | %-23.23s | %18.18s | %-10s |\n", idWidth, val[i].ID, TypeText(val[i].prijemVydaj).c_str(), CategoryText(val[i].kategorie).c_str(), (val[i].castkaPlatna ? SpacedMoneyValue(val[i].castka, money).data() : "x"), date.c_str());
+	}
+	printf("|%s|________|_________________________|____________________|____________|\n\n", idBorder.c_str());
+}
+
+/**
+ * @brief Funkce kontroluje zadanou castku, jestli je cislo a jestli neprekrocila limit 999,999,999,999.99 Kc, nebo neni zaporna
+ * @param money zadana castka ve stringu
+ * @param errorLog struktura pro ukladani chyb
+ * @param id pro zaznam chyby
+ * @param castka sem se ulozi castka v halerich, pokud odpovida podminkam
+ * @return true pokud je castka platna, false pokud zadana castka neni cislo, je moc velka, nebo zaporna
+ */
+bool CheckMoney(string_view money, ErrorLog &errorLog, int id, int64_t &castka)
+{
+	int64_t halere;
+	NumberStatus status = ParseMoney(money, halere);
+
+	if (status == NUMBER_INVALID)
+	{
+		// money is not a number
+		LogError(errorLog, ERROR_MONEY_NOT_NUMBER, id);
+		return false;
+	}
+	else if (status == NUMBER_OUT_OF_RANGE || !MoneyIsNotOverMaxValue(halere))
+	{
+		// money value is bigger than 999,999,999,999.99
+		LogError(errorLog, ERROR_MONEY_RANGE, id);
+		return false;
+	}
+
+	// money value is correct
+	castka = halere;
+	return true;
+}
+
+/**
+ * @brief Funkce pro kontrolu velikosti penezni castky
+ * @param halere zadana castka v halerich
+ * @return true, pokud castka neprekrocila danou velikost a neni zaporna, false pokud prekrocila MAX_CASTKA
+ */
+bool MoneyIsNotOverMaxValue(int64_t halere)
+{
+	return halere >= 0 && halere <= MAX_CASTKA;
+}
+
+/**
+ * @brief Funkce pro prevod penezni castky na formatovany vzhled s oddelovanim po trech cislech
+ *
+ * Pise se zprava doleva do bufferu na zasobniku, po trojicich cislic s tabulkou dvojic cislic, bez alokaci.
+ * Oddelovac tisicu je MONEY_DELIMITER, pri MONEY_HALERE se pridaji i halere, jinak se zaokrouhli na cele Kc.
+ * @param castka castka v halerich
+ * @param buffer buffer, do ktereho se castka zapise
+ * @return naformatovana castka, ukazuje do bufferu a je ukoncena '\0'
+ */
+string_view SpacedMoneyValue(int64_t castka, MoneyBuffer &buffer)
+{
+	static const char digitPairs[201] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+	char *end = buffer.text + sizeof(buffer.text) - 1;
+	char *p = end;
+	*p = '\0';
+
+	bool negative = castka < 0;
+	uint64_t value = negative ? 0 - (uint64_t)castka : (uint64_t)castka;
+	char delimiter = MONEY_DELIMITER[0];
+
+	if (MONEY_HALERE)
+	{
+		unsigned int halere = value % 100;
+		value /= 100;
+		p -= 2;
+		memcpy(p, digitPairs + 2 * halere, 2);
+		*--p = (delimiter == ',' ? '.' : ',');
+		negative = negative && (value != 0 || halere != 0);
+	}
+	else
+	{
+		value = (value + 50) / 100;		// zaokrouhleni na cele Kc (0.5 nahoru)
+		negative = negative && value != 0;
+	}
+
+	while (value >= 1000)
+	{
+		unsigned int group = value % 1000;
+		value /= 1000;
+		p -= 2;
+		memcpy(p, digitPairs + 2 * (group % 100), 2);
+		*--p = '0' + group / 100;
+		*--p = delimiter;
+	}
+	if (value >= 100)
+	{
+		p -= 2;
+		memcpy(p, digitPairs + 2 * (value % 100), 2);
+		*--p = '0' + value / 100;
+	}
+	else if (value >= 10)
+	{
+		p -= 2;
+		memcpy(p, digitPairs + 2 * value, 2);
+	}
+	else
+		*--p = '0' + value;
+
+	if (negative)
+		*--p = '-';
+	return string_view(p, end - p);
+}
+
+/**
+ * @brief Funkce pro pridani novych dat zadavanych uzivatelem z klavesnice
+ * @param ucetniData kde se ulozi data k ostatnim datum nactenym z csv
+ * @param idIndex index obsazenych ID, prida se do nej ID noveho zaznamu
+ */
+void AddData(vector<UcetniData> &ucetniData, IdIndex &idIndex)
+{
+	bool canAdd = true;
+		ucetniData.push_back(UcetniData());
+
+		string date;
+		unsigned int lengthData = ucetniData.size() - 1;
+		int lastId = FreeId(idIndex);		// journal musi jit znovu nacist, proto jen ID 0 - MAX_ID
+		char category[24];
+
+		if (lastId == -1)
+			canAdd = false;
+
+		ucetniData[lengthData].ID = lastId;
+
+		if (canAdd)
+		{
+			cout << "Zadejte cislo akce:" << endl;
+			cout << "1 - prijem\n2 - vydaj" << endl;
+			int num;
+			if (cin >> num)
+			{
+				if (num == 1)
+					ucetniData[lengthData].prijemVydaj = TYP_PRIJEM;
+				else if (num == 2)
+					ucetniData[lengthData].prijemVydaj = TYP_VYDAJ;
+				else
+				{
+					cout << "Neplatny vstup." << endl << endl;
+					canAdd = false;
+				}
+			}
+			else {
+				cout << "Neplatny vstup." << endl << endl;
+				canAdd = false;
+				//break;
+			}
+
+			if (canAdd)
+			{
+				cout << "Zadejte kratky popis max 23 znaku (nepouzivejte znak \",\"):" << endl;
+				cin.ignore();
+				cin.getline(category, 23);
+				replace(category, category + strlen(category), DELIMITER, ' ');	// oddelovac by v journalu rozdelil radek
+				ucetniData[lengthData].kategorie = InternCategory(category, categories);
+				//cin.ignore(INT_MAX);
+
+				cout << "Zadejte castku v Kc:" << endl;
+				string moneyText;
+				int64_t money;
+				NumberStatus status = NUMBER_INVALID;
+				if (cin >> moneyText)
+					status = ParseMoney(moneyText, money);
+
+				if (status != NUMBER_INVALID)
+				{
+					if (status == NUMBER_OK && MoneyIsNotOverMaxValue(money))
+					{
+						ucetniData[lengthData].castka = money;
+						ucetniData[lengthData].castkaPlatna = true;
+					}
+					else
+					{
+						cout << "Zadali jste prilis velkou, nebo zapornou castku!" << endl;
+						canAdd = false;
+						//break;
+					}
+
+				}
+				else
+				{
+					cout << "Zadali jste neplatnou castku penez!" << endl;
+					canAdd = false;
+					//break;
+				}
+			}
+			if (canAdd)
+			{
+				//struct tm timeinfo;
+				//localtime_s(&timeinfo, &t);
+				//errno_t error = localtime_s(&timeinfo, &t);
+
+				//cout << asctime_s(localtime(&t)) << '\n';
+				//tm *ltm = localtime(&now);
+				// print various components of tm structure.
+				//cout << "Year" << 1970 + ltm->tm_year << endl;
+				//cout << "Month: " << 1 + ltm->tm_mon << endl;
+				//cout << "Day: " << ltm->tm_mday << endl;
+
+                struct tm *timeinfo;
+                time(&rawtime);
+                timeinfo = localtime ( &rawtime );
+
+                string cDay = to_string(timeinfo->tm_mday);
+                string cMonth = to_string(1 + timeinfo->tm_mon);
+                string cYear = to_string(1900 + timeinfo->tm_year);
+
+                if (cDay.length() < 2)
+                    cDay.insert(0, "0");
+                if (cMonth.length() < 2)
+                    cMonth.insert(0, "0");
+                date = cDay + TIME_DELIMITER + cMonth + TIME_DELIMITER + cYear;
+
+                //
+				//string cDay = to_string((&timeinfo)->tm_mday);
+				//string cMonth = to_string(1 + (&timeinfo)->tm_mon);
+				//string cYear = to_string(1900 + (&timeinfo)->tm_year);
+
+				//if (cDay.length() < 2)
+				//	cDay.insert(0, "0");
+				//if (cMonth.length() < 2)
+				//	cMonth.insert(0, "0");
+
+				//date = cDay + TIME_DELIMITER + cMonth + TIME_DELIMITER + cYear;
+				ucetniData[lengthData].datum = PackDate(timeinfo->tm_mday, 1 + timeinfo->tm_mon, 1900 + timeinfo->tm_year);
+				//string date = to_string((&timeinfo)->tm_mday) + TIME_DELIMITER + to_string(1 + (&timeinfo)->tm_mon) + TIME_DELIMITER + to_string( 1900 + (&timeinfo)->tm_year);
+			}
+			if (canAdd)
+			{
+				MoneyBuffer money;
+				RegisterId(ucetniData[lengthData].ID, idIndex);
+				if (balanceIndex.records != 0)
+					UpdateBalanceIndex(ucetniData);		// jen pricteni noveho zaznamu
+				if (!JournalAppend(journal, JournalLine(ucetniData[lengthData], TrimCategory(category))))
+					cout << "Zaznam se nepodarilo ulozit do " << journal.path << "!" << endl;
+				cout << endl << "Zadali jste:" << endl;
+				cout << "ID: " << ucetniData[lengthData].ID << " |  " << TypeText(ucetniData[lengthData].prijemVydaj) << "\t" << CategoryText(ucetniData[lengthData].kategorie) << "\t" << SpacedMoneyValue(ucetniData[lengthData].castka, money) << "\t" << date << endl;
+				cout << endl;
+			}
+			else
+			{
+				ucetniData.pop_back();
+			}
+
+		}
+		else
+		{
+			cout << "Nelze pridat dalsi polozku." << endl;
+			ucetniData.pop_back();
+			//break;
+		}
+}
+
+/**
+ * @brief Funkce zkontroluje datum a ulozi ho do zaznamu jako RRRRMMDD, neplatne datum zapise do chyb
+ *
+ * Stejne texty datumu se v souborech opakuji, proto si vysledky ParseDate pamatuje v male cache
+ * (DATE_CACHE_SIZE polozek na vlakno, stejny text ma vzdy stejny vysledek).
+ * @param time - zadany cas (pole radku .csv souboru)
+ * @param overallRows - index zaznamu ve values
+ * @param errorLog - struktura errorLogu
+ * @param id - id pro errory
+ * @param values - ucetnidata
+ */
+void TimeFormat(string_view time, unsigned int overallRows, ErrorLog &errorLog, int id, vector<UcetniData> &values)
+{
+	thread_local DateCacheEntry cache[DATE_CACHE_SIZE];
+	uint32_t datum;
+	ErrorCode error;
+
+	if (time.size() > sizeof(DateCacheEntry::text))
+		datum = ParseDate(time, error);		// dlouhe texty se do cache neukladaji
+	else
+	{
+		uint32_t hash = 2166136261u;
+		for (char c : time)
+			hash = (hash ^ (unsigned char)c) * 16777619u;
+		DateCacheEntry &entry = cache[(hash ^ (hash >> 16)) & (DATE_CACHE_SIZE - 1)];
+
+		if (!entry.valid || entry.length != time.size() || memcmp(entry.text, time.data(), time.size()) != 0)
+		{
+			entry.datum = ParseDate(time, entry.error);
+			memcpy(entry.text, time.data(), time.size());
+			entry.length = time.size();
+			entry.valid = true;
+		}
+		datum = entry.datum;
+		error = entry.error;
+	}
+
+	if (datum != 0)
+		values[overallRows].datum = datum;
+	else
+		LogError(errorLog, error, id);
+}
+
+/**
+ * @brief Funkce prevede datum D.M.RRRR (oddelovace ' ', '.', '-', ':', den a mesic i s uvodni nulou) na RRRRMMDD
+ *
+ * Jeden pruchod textem, druhy znaku urcuje tabulka DATE_CHARS a pocet dnu mesice tabulka DAYS_IN_MONTH.
+ * Rok se cte od prvniho znaku za druhym oddelovacem (jako ParseInt), povolene roky jsou 1582 - 9999.
+ * @param time - zadany cas (pole radku .csv souboru)
+ * @param error - sem se ulozi druh chyby, pokud datum neni platne
+ * @return datum RRRRMMDD, nebo 0 pokud datum neni platne
+ */
+uint32_t ParseDate(string_view time, ErrorCode &error)
+{
+	int day = 0, month = 0, year = 0;
+	int completDate = 0;
+	bool correctDate = true;
+	bool wrongDay = false, wrongMonth = false;
+	int numberOfDelimiters = 0;
+	size_t pos = 0;
+
+	for (size_t i = 0; i < time.size() && correctDate; i++)
+	{
+		DateChar type = DATE_CHARS.type[(unsigned char)time[i]];
+		if (type == DATE_CHAR_DELIMITER)
+		{
+			size_t length = i - pos;
+			char first = (length > 0 ? time[pos] : 0);
+			char second = (length > 1 ? time[pos + 1] : 0);
+			bool firstDigit = DATE_CHARS.type[(unsigned char)first] == DATE_CHAR_DIGIT;
+			bool secondDigit = DATE_CHARS.type[(unsigned char)second] == DATE_CHAR_DIGIT;
+			int value = (length == 1 ? first - '0' : (first - '0') * 10 + second - '0');
+
+			if (numberOfDelimiters == 0)		// den /D/, /0D/, /DD/
+			{
+				if (length == 1 && firstDigit && first != '0')
+					day = value, completDate++;
+				else if (length == 2 && first == '0' && second != '0')
+				{
+					if (secondDigit)
+						day = value, completDate++;
+					else
+						correctDate = false;
+				}
+				else if (length == 2 && first != '0')
+				{
+					if (firstDigit && secondDigit && value >= 10 && value <= 31)
+						day = value, completDate++;
+					else
+						correctDate = false, wrongDay = true;
+				}
+				else if (length > 2 || length == 0)
+					correctDate = false, wrongDay = true;
+				else
+					correctDate = false;
+			}
+			else if (numberOfDelimiters == 1)	// mesic /M/, /0M/, /MM/
+			{
+				if (length == 1 && firstDigit && first != '0')
+					month = value, completDate++;
+				else if (length == 2 && first == '0' && second != '0')
+				{
+					if (secondDigit)		// "0x" se jako mesic nezapocita, ale neni chyba
+						month = value, completDate++;
+				}
+				else if (length == 2 && first != '0')
+				{
+					if (firstDigit && secondDigit && value >= 10 && value <= 12)
+						month = value, completDate++;
+					else
+						correctDate = false, wrongMonth = true;
+				}
+				else
+					correctDate = false;
+			}
+			pos = i + 1;
+			numberOfDelimiters++;
+		}
+		else if (numberOfDelimiters == 2)		// rok /YYYY/, od prvniho znaku do konce pole
+		{
+			if (i < time.size() - 1)
+			{
+				if (ParseInt(time.substr(pos), year) != NUMBER_OK)
+					year = -1;
+				correctDate = (year >= 1582 && year <= 9999);
+				completDate += correctDate;
+			}
+			break;
+		}
+	}
+
+	if (correctDate && completDate == 3)
+	{
+		if (day <= DAYS_IN_MONTH[IsLeapYear(year)][month])
+			return PackDate(day, month, year);		// spravny datum
+		error = ERROR_DATE_LEAP_YEAR;		// den za koncem mesice, napr. 29.02. v neprestupnem roce
+	}
+	else if (wrongDay)
+		error = ERROR_DATE_DAY;
+	else if (wrongMonth)
+		error = ERROR_DATE_MONTH;
+	else if (year == 0)
+		error = ERROR_DATE_MISSING;
+	else
+		error = ERROR_DATE_FORMAT;
+	return 0;
+}
+
+/**
+ * @brief Funkce prevede string na int bez vyjimek, chova se jako stoi (uvodni mezery, znamenko, cte se jen cislo na zacatku)
+ * @param num - zadany string pro prevod
+ * @param value - sem se ulozi prevedene cislo, pokud je vysledek NUMBER_OK
+ * @return NUMBER_OK, NUMBER_INVALID pokud string nezacina cislem, NUMBER_OUT_OF_RANGE pokud se cislo nevejde do int
+ */
+NumberStatus ParseInt(string_view num, int &value)
+{
+	size_t i = 0;
+	while (i < num.size() && isspace((unsigned char)num[i]))
+		i++;
+
+	bool negative = false;
+	if (i < num.size() && (num[i] == '+' || num[i] == '-'))
+		negative = (num[i++] == '-');
+
+	size_t firstDigit = i;
+	long long result = 0;
+	bool overflow = false;
+	for (; i < num.size() && num[i] >= '0' && num[i] <= '9'; i++)
+	{
+		if (!overflow)
+		{
+			result = result * 10 + (num[i] - '0');
+			if (result > (long long)INT_MAX + 1)
+				overflow = true;
+		}
+	}
+
+	if (i == firstDigit)
+		return NUMBER_INVALID;
+	if (negative)
+		result = -result;
+	if (overflow || result > INT_MAX || result < INT_MIN)
+		return NUMBER_OUT_OF_RANGE;
+
+	value = (int)result;
+	return NUMBER_OK;
+}
+
+/**
+ * @brief Funkce prevede string s castkou v Kc na haleru bez vyjimek (uvodni mezery, znamenko, cte se jen cislo na zacatku)
+ *
+ * Desetinna cast se bere na dve mista, treti desetinne misto se zaokrouhli (0.5 nahoru), dalsi se ignoruji.
+ * @param num - zadany string pro prevod
+ * @param halere - sem se ulozi prevedena castka v halerich, pokud je vysledek NUMBER_OK
+ * @return NUMBER_OK, NUMBER_INVALID pokud string nezacina cislem, NUMBER_OUT_OF_RANGE pokud je castka vetsi nez MAX_CASTKA
+ */
+NumberStatus ParseMoney(string_view num, int64_t &halere)
+{
+	size_t i = 0;
+	while (i < num.size() && isspace((unsigned char)num[i]))
+		i++;
+
+	bool negative = false;
+	if (i < num.size() && (num[i] == '+' || num[i] == '-'))
+		negative = (num[i++] == '-');
+
+	int digits = 0;
+	int64_t koruny = 0;
+	bool overflow = false;
+	for (; i < num.size() && num[i] >= '0' && num[i] <= '9'; i++, digits++)
+	{
+		koruny = koruny * 10 + (num[i] - '0');
+		if (koruny > MAX_CASTKA)
+		{
+			overflow = true;
+			koruny = MAX_CASTKA;
+		}
+	}
+
+	int64_t fraction = 0;
+	if (i < num.size() && num[i] == '.')
+	{
+		int place = 0;
+		for (i++; i < num.size() && num[i] >= '0' && num[i] <= '9'; i++, digits++, place++)
+		{
+			if (place < 2)
+				fraction = fraction * 10 + (num[i] - '0');
+			else if (place == 2 && num[i] >= '5')
+				fraction++;		// zaokrouhleni podle tretiho desetinneho mista
+		}
+		if (place == 1)
+			fraction *= 10;
+	}
+
+	if (digits == 0)
+		return NUMBER_INVALID;
+
+	int64_t result = koruny * 100 + fraction;
+	if (overflow || result > MAX_CASTKA)
+		return NUMBER_OUT_OF_RANGE;
+
+	halere = negative ? -result : result;
+	return NUMBER_OK;
+}
+
+/**
+ * @brief Funkce, ktera kontroluje spravnost ID
+ * @param strId - strId je id k porovnani
+ * @param idIndex - index obsazenych ID k porovnani s strId
+ * @param errorLog - struktura pro ukladani chyb
+ * @param id - sem se ulozi prevedene ID
+ * @return true, pokud id neni obsazen v ucetnich datech, false ze uz tam je obsazen
+ */
+bool IsValidID(string_view strId, const IdIndex &idIndex, ErrorLog &errorLog, int &id)
+{
+	if (ParseInt(strId, id) == NUMBER_OK)
+	{
+		if (IsIdDuplicated(id, idIndex))
+		{
+			// error message --> duplicated IDs not allowed
+			return false;
+		}
+		else if (id > MAX_ID || id < -1)
+		{
+			// error message --> ID is too low or too big
+			LogError(errorLog, id > MAX_ID ? ERROR_ID_TOO_BIG : ERROR_ID_NEGATIVE, id);
+			return false;
+		}
+		else
+		{
+			return true;
+		}
+	}
+	else
+	{
+		// error message --> ID is not a number
+		return false;
+	}
+}
+
+/**
+ * @brief Funkce, ktera kontroluje duplicitni ID
+ * @param id - id ke kontrole
+ * @param idIndex - index obsazenych ID
+ * @return true, pokud se jiz stejne id vyskytuje, false pokud id neni duplicitni s ostatnima id v ucetnichDatech
+ */
+bool IsIdDuplicated(int id, const IdIndex &idIndex)
+{
+	if (id == -1)
+		return idIndex.invalidUsed;
+	if (id < 0)
+		return false;
+	if (id > MAX_ID)
+		return idIndex.namespaced.count(id) != 0;
+	return idIndex.used.test(id);
+}
+
+/**
+ * @brief Funkce zapise ID zaznamu do indexu obsazenych ID
+ * @param id - id noveho zaznamu
+ * @param idIndex - index obsazenych ID
+ */
+void RegisterId(int id, IdIndex &idIndex)
+{
+	if (id == -1)
+		idIndex.invalidUsed = true;
+	else if (id >= 0 && id <= MAX_ID)
+		idIndex.used.set(id);
+	else if (id > MAX_ID)
+		idIndex.namespaced.insert(id);
+}
+
+/**
+ * @brief Funkce najde nejmensi volne ID pro novy zaznam
+ * @param idIndex index obsazenych ID
+ * @return nejmensi neobsazene ID 0 - MAX_ID, -1 pokud jsou vsechna obsazena
+ */
+int FreeId(const IdIndex &idIndex)
+{
+	if (idIndex.used.all())
+		return -1;
+	int id = 0;
+	while (idIndex.used.test(id))
+		id++;
+	return id;
+}
+
+/**
+ * @brief Funkce pro kontrolu, jestli vstup obsahuje "prijem", nebo "vydaj" (bez ohledu na velikost pismen)
+ * @param category string pro zkontrolovani
+ * @return vraci TYP_PRIJEM, nebo TYP_VYDAJ, jinak vraci TYP_NEPLATNY
+ */
+TypZaznamu CheckIncomeExpenditure(string_view category)
+{
+	auto equalsLower = [category](string_view lower)
+	{
+		if (category.size() != lower.size())
+			return false;
+		for (size_t i = 0; i < lower.size(); i++)
+		{
+			if (tolower((unsigned char)category[i]) != lower[i])
+				return false;
+		}
+		return true;
+	};
+
+	if (equalsLower("prijem"))
+		return TYP_PRIJEM;
+	else if (equalsLower("vydaj"))
+		return TYP_VYDAJ;
+	else
+		return TYP_NEPLATNY;
+}
+
+/**
+ * @brief Funkce vrati textovou podobu typu zaznamu
+ * @param typ typ zaznamu
+ * @return "prijem", "vydaj", nebo "x" pro neplatny typ
+ */
+string TypeText(TypZaznamu typ)
+{
+	if (typ == TYP_PRIJEM)
+		return "prijem";
+	else if (typ == TYP_VYDAJ)
+		return "vydaj";
+	else
+		return "x";
+}
+
+/**
+ * @brief Funkce odstrani mezery na zacatku a na konci kategorie
+ * @param name nazev kategorie
+ * @return nazev kategorie bez okrajovych mezer
+ */
+string_view TrimCategory(string_view name)
+{
+	while (!name.empty() && isspace((unsigned char)name.front()))
+		name.remove_prefix(1);
+	while (!name.empty() && isspace((unsigned char)name.back()))
+		name.remove_suffix(1);
+	return name;
+}
+
+/**
+ * @brief Funkce vrati ID kategorie ve slovniku kategorii, nova kategorie se do slovniku prida
+ * @param name nazev kategorie
+ * @param dictionary slovnik kategorii (globalni categories, nebo lokalni slovnik casti pri paralelnim nacitani)
+ * @return ID kategorie
+ */
+uint32_t InternCategory(string_view name, CategoryDictionary &dictionary)
+{
+	static thread_local string key;		// znovu pouzivany buffer, aby se pri hledani nealokovalo
+	name = TrimCategory(name);
+	key.assign(name.data(), name.size());
+	for (char &c : key)
+		c = tolower((unsigned char)c);
+
+	auto it = dictionary.ids.find(key);
+	if (it != dictionary.ids.end())
+		return it->second;
+
+	uint32_t id = dictionary.names.size();
+	dictionary.names.emplace_back(name);
+	dictionary.ids.emplace(key, id);
+	return id;
+}
+
+/**
+ * @brief Funkce vrati nazev kategorie podle jejiho ID
+ * @param id ID kategorie ve slovniku kategorii
+ * @return nazev kategorie
+ */
+const string& CategoryText(uint32_t id)
+{
+	return categories.names[id];
+}
+
+/**
+ * @brief Funkce zabali datum do jednoho cisla RRRRMMDD
+ * @param day den
+ * @param month mesic
+ * @param year rok
+ * @return datum jako RRRRMMDD
+ */
+uint32_t PackDate(int day, int month, int year)
+{
+	return year * 10000 + month * 100 + day;
+}
+
+/**
+ * @brief Funkce vrati rok ze zabaleneho datumu
+ * @param datum datum RRRRMMDD
+ * @return rok
+ */
+int DateYear(uint32_t datum)
+{
+	return datum / 10000;
+}
+
+/**
+ * @brief Funkce vrati mesic ze zabaleneho datumu
+ * @param datum datum RRRRMMDD
+ * @return mesic 1 - 12
+ */
+int DateMonth(uint32_t datum)
+{
+	return datum / 100 % 100;
+}
+
+/**
+ * @brief Funkce vrati den ze zabaleneho datumu
+ * @param datum datum RRRRMMDD
+ * @return den 1 - 31
+ */
+int DateDay(uint32_t datum)
+{
+	return datum % 100;
+}
+
+/**
+ * @brief Funkce prevede zabalene datum na text DD.MM.RRRR s oddelovacem TIME_DELIMITER
+ * @param datum datum RRRRMMDD
+ * @return datum jako text, u neplatneho datumu jen dva oddelovace (napr. "..")
+ */
+string DateText(uint32_t datum)
+{
+	if (datum == 0)
+		return string(2, TIME_DELIMITER);
+
+	char text[11] = { 0 };
+	int day = DateDay(datum), month = DateMonth(datum), year = DateYear(datum);
+	text[0] = '0' + day / 10;
+	text[1] = '0' + day % 10;
+	text[2] = TIME_DELIMITER;
+	text[3] = '0' + month / 10;
+	text[4] = '0' + month % 10;
+	text[5] = TIME_DELIMITER;
+	text[6] = '0' + year / 1000;
+	text[7] = '0' + year / 100 % 10;
+	text[8] = '0' + year / 10 % 10;
+	text[9] = '0' + year % 10;
+	return string(text, 10);
+}
+
+/**
+ * @brief Funkce pro vypis chyb
+ * @param errorLog je struktura s ulozenyma chybama
+ */
+void PrintErrors(ErrorLog &errorLog)
+{
+	cout << "Info:" << endl;
+	cout << "Duplicitni ID jsou zaznamenana jako \"-1\". Prazdne, ci neplatne vyplnene pole jsou \"x\"." << endl;
+	cout << "Radek, ktery obsahuje duplicitni ID, prazdne, ci nespravne vyplnene pole,\nnebude do html vypsan!" << endl << endl;
+	cout << "Error list:" << endl;
+	size_t count = errorLog.entries.size();
+	if (count == 0)
+		cout << "No Errors" << endl;
+	else if (ERROR_OUTPUT == 3)
+	{
+		string path = GetErrorFilePath();
+		ofstream file(path);
+		for (const ErrorEntry &entry : errorLog.entries)
+			PrintError(file, entry);
+		file.close();
+		if (file.fail())
+			cout << "Soubor " << path << " nelze zapsat!" << endl;
+		else
+			cout << "Vsech " << count << " chyb zapsano do souboru " << path << endl;
+	}
+	else
+	{
+		// prvnich ERROR_LIMIT chyb, nebo kazda step-ta chyba (rovnomerny vzorek)
+		size_t limit = (ERROR_OUTPUT == 0 ? count : min<size_t>(count, ERROR_LIMIT));
+		size_t step = (ERROR_OUTPUT == 2 ? (count + limit - 1) / limit : 1);
+		size_t printed = 0;
+		for (size_t x = 0; x < count && printed < limit; x += step, printed++)
+			PrintError(cout, errorLog.entries[x]);
+		if (printed < count)
+			cout << "... vypsano " << printed << " z " << count << " chyb" << endl;
+	}
+	if (count != 0)
+	{
+		cout << endl << "Pocty chyb:" << endl;
+		for (int code = 0; code < ERROR_CODE_COUNT; code++)
+		{
+			if (errorLog.counts[code] != 0)
+				cout << errorLog.counts[code] << "\t" << ErrorMessage((ErrorCode)code) << endl;
+		}
+	}
+	cout << "---------------------------------------------------------------------------------------" << endl;
+	cout << endl;
+	if (STATS_ENABLED)
+		PrintStats(errorLog);
+}
+
+/**
+ * @brief Funkce vypise jednu chybu
+ * @param out kam se chyba vypise
+ * @param entry chyba
+ */
+void PrintError(ostream &out, const ErrorEntry &entry)
+{
+	out << "Id: " << entry.id << "\t" << ErrorMessage(entry.code);
+	if (entry.file != 0 && entry.file <= inputFiles.size())
+		out << " (soubor " << FileName(inputFiles[entry.file - 1]) << ", radek " << entry.line << ")";
+	else if (entry.line != 0)
+		out << " (radek " << entry.line << ")";
+	out << "\n";
+}
+
+/**
+ * @brief Funkce zaznamena chybu k aktualnimu radku errorLog.line
+ * @param errorLog struktura pro ukladani chyb
+ * @param code druh chyby
+ * @param id id zaznamu s chybou
+ */
+void LogError(ErrorLog &errorLog, ErrorCode code, int id)
+{
+	errorLog.entries.push_back({ id, errorLog.line, code, errorLog.file });
+	errorLog.counts[code]++;
+}
+
+/**
+ * @brief Funkce vrati text chyby
+ * @param code druh chyby
+ * @return text chyby
+ */
+const char *ErrorMessage(ErrorCode code)
+{
+	switch (code)
+	{
+	case ERROR_ID_TOO_BIG: return "ID je vetsi jak 9999";
+	case ERROR_ID_NEGATIVE: return "ID je zaporne";
+	case ERROR_MONEY_NOT_NUMBER: return "Zadana penezni castka neni cislo.";
+	case ERROR_MONEY_RANGE: return "Penezni castka presahla maxima 999,999,999,999 Kc, nebo je zaporna.";
+	case ERROR_DATE_LEAP_YEAR: return "Neplatny rok --> prestupny rok";
+	case ERROR_DATE_FORMAT: return "Nespravne zadane datum.";
+	case ERROR_DATE_DAY: return "Neplatny rok --> Nespravne zadany den";
+	case ERROR_DATE_MONTH: return "Neplatny rok --> Nespravne zadany mesic";
+	case ERROR_DATE_MISSING: return "Neplatny rok --> Chybi datum";
+	default: return "Neznama chyba";
+	}
+}
+
+/**
+ * @brief Funkce vrati cestu k souboru s chybami, je vedle vystupniho html souboru
+ * @return cesta k souboru s chybami
+ */
+string GetErrorFilePath()
+{
+	return OutputSiblingPath("_chyby.txt");
+}
+
+/**
+ * @brief Funkce vrati cestu k souboru vedle vystupniho html souboru (nazev html bez .html a pripona)
+ * @param suffix pripona nazvu
+ * @return cesta k souboru
+ */
+string OutputSiblingPath(const char *suffix)
+{
+	string path = (outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath);
+	if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".html") == 0)
+		path.erase(path.size() - 5);
+	return path + suffix;
+}
+
+/**
+ * @brief Konstruktor zacne merit usek, pokud jsou statistiky zapnute
+ * @param measured mereny usek
+ */
+StatsTimer::StatsTimer(StatsPhase measured) : phase(measured), active(STATS_ENABLED), totals(nullptr)
+{
+	if (active)
+		start = chrono::steady_clock::now();
+}
+
+/**
+ * @brief Konstruktor zacne merit usek, cas se pricte jen k lokalnim souctum (pro mereni po polich v cyklech nacitani)
+ * @param measured mereny usek
+ * @param local lokalni soucty, do statistik je pricte StatsMerge
+ */
+StatsTimer::StatsTimer(StatsPhase measured, PhaseTotals &local) : phase(measured), active(STATS_ENABLED), totals(&local)
+{
+	if (active)
+		start = chrono::steady_clock::now();
+}
+
+/**
+ * @brief Destruktor pricte nameny cas k useku
+ */
+StatsTimer::~StatsTimer()
+{
+	if (!active)
+		return;
+	uint64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	if (totals != nullptr)
+	{
+		totals->nanoseconds[phase] += elapsed;
+		totals->calls[phase]++;
+		return;
+	}
+	phaseStats[phase].nanoseconds += elapsed;
+	phaseStats[phase].calls++;
+}
+
+/**
+ * @brief Funkce pricte lokalni soucty casu k useku, jedna atomicka operace za usek misto jedne za pole
+ * @param totals lokalni soucty (StatsTimer s lokalnimi soucty)
+ */
+void StatsMerge(const PhaseTotals &totals)
+{
+	for (int p = 0; p < PHASE_COUNT; p++)
+	{
+		if (totals.calls[p] == 0)
+			continue;
+		phaseStats[p].nanoseconds += totals.nanoseconds[p];
+		phaseStats[p].calls += totals.calls[p];
+	}
+}
+
+/**
+ * @brief Funkce pricte radky a bajty k useku, pokud jsou statistiky zapnute
+ * @param phase usek
+ * @param rows pocet radku / zaznamu
+ * @param bytes pocet bajtu
+ */
+void StatsCount(StatsPhase phase, uint64_t rows, uint64_t bytes)
+{
+	if (!STATS_ENABLED)
+		return;
+	phaseStats[phase].rows += rows;
+	phaseStats[phase].bytes += bytes;
+}
+
+/**
+ * @brief Funkce spocita odmitnute zaznamy (nevypisou se do html) podle duvodu, pokud jsou statistiky zapnute
+ * @param values ucetni data
+ * @param first index prvniho nove nacteneho zaznamu
+ */
+void StatsCountRejected(const vector<UcetniData> &values, size_t first)
+{
+	if (!STATS_ENABLED)
+		return;
+	uint64_t rejected[REJECT_COUNT + 1] = { 0 };
+	for (size_t i = first; i < values.size(); i++)
+	{
+		const UcetniData &zaznam = values[i];
+		rejected[REJECT_ID] += (zaznam.ID == -1);
+		rejected[REJECT_TYPE] += (zaznam.prijemVydaj == TYP_NEPLATNY);
+		rejected[REJECT_CATEGORY] += (CategoryText(zaznam.kategorie).length() == 0);
+		rejected[REJECT_MONEY] += !zaznam.castkaPlatna;
+		rejected[REJECT_DATE] += (zaznam.datum == 0);
+		rejected[REJECT_COUNT] += !IsReportable(zaznam);
+	}
+	for (int r = 0; r <= REJECT_COUNT; r++)
+		rejectedStats[r] += rejected[r];
+}
+
+/**
+ * @brief Funkce vynuluje vsechny statistiky
+ */
+void StatsReset()
+{
+	for (PhaseStats &stats : phaseStats)
+	{
+		stats.nanoseconds = 0;
+		stats.calls = 0;
+		stats.rows = 0;
+		stats.bytes = 0;
+	}
+	for (atomic<uint64_t> &rejected : rejectedStats)
+		rejected = 0;
+}
+
+/**
+ * @brief Funkce vypise statistiky behu jako JSON: casy a pocitadla useku, odmitnute radky a pocty chyb podle druhu
+ * @param errorLog struktura s ulozenyma chybama
+ */
+void PrintStats(const ErrorLog &errorLog)
+{
+	static const char *phaseNames[PHASE_COUNT] = { "read", "snapshot", "tokenize", "validate_id", "validate_money",
+		"validate_date", "sort", "aggregate", "html_render", "html_write" };
+	static const char *rejectNames[REJECT_COUNT + 1] = { "id", "type", "category", "money", "date", "total" };
+
+	char number[64];
+	cout << "{\n\t\"enabled\": " << (STATS_ENABLED ? "true" : "false") << ",\n\t\"phases\": {\n";
+	for (int p = 0; p < PHASE_COUNT; p++)
+	{
+		snprintf(number, sizeof(number), "%.3f", phaseStats[p].nanoseconds / 1e6);
+		cout << "\t\t\"" << phaseNames[p] << "\": { \"ms\": " << number << ", \"calls\": " << phaseStats[p].calls
+			<< ", \"rows\": " << phaseStats[p].rows << ", \"bytes\": " << phaseStats[p].bytes << " }" << (p + 1 < PHASE_COUNT ? "," : "") << "\n";
+	}
+	cout << "\t},\n\t\"rejected_rows\": {";
+	for (int r = 0; r <= REJECT_COUNT; r++)
+		cout << (r != 0 ? ", " : " ") << "\"" << rejectNames[r] << "\": " << rejectedStats[r];
+	cout << " },\n\t\"errors\": {";
+	size_t e = 0;
+	for (int code = 0; code < ERROR_CODE_COUNT; code++)
+	{
+		if (errorLog.counts[code] != 0)
+			cout << (e++ != 0 ? ",\n\t\t" : "\n\t\t") << JsonString(ErrorMessage((ErrorCode)code)) << ": " << errorLog.counts[code];
+	}
+	cout << (e == 0 ? "}" : "\n\t}") << "\n}" << endl << endl;
+}
+
+/**
+ * @brief Funkce prevede text na JSON retezec vcetne uvozovek
+ * @param text text
+ * @return JSON retezec
+ */
+string JsonString(string_view text)
+{
+	string json = "\"";
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			json += '\\';
+			json += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+			json += escaped;
+		}
+		else
+			json += c;
+	}
+	return json + "\"";
+}
+
+/**
+ * @brief Funkce zjisti, jestli se zaznam muze vypsat do html (platne ID, typ, kategorie, castka i datum)
+ * @param zaznam zaznam ucetnich dat
+ * @return true pokud je zaznam cely platny
+ */
+bool IsReportable(const UcetniData &zaznam)
+{
+	return zaznam.ID != -1 && zaznam.prijemVydaj != TYP_NEPLATNY && CategoryText(zaznam.kategorie).length() != 0
+		&& zaznam.castkaPlatna && zaznam.datum != 0;
+}
+
+/**
+ * @brief Funkce vytvori klic pro razeni html vystupu
+ *
+ * Klic roste v poradi, v jakem se zaznamy vypisuji: nejnovejsi mesic prvni a v mesici nejvyssi castka prvni.
+ * Horni bity jsou obraceny index mesicu (rok * 12 + mesic, max 120 000 < 2^17), dolnich 47 bitu obracena castka.
+ * @param zaznam platny zaznam ucetnich dat
+ * @return klic pro vzestupne razeni
+ */
+uint64_t ReportSortKey(const UcetniData &zaznam)
+{
+	const uint64_t maxMonthIndex = (1 << 17) - 1;
+	uint64_t monthIndex = (uint64_t)DateYear(zaznam.datum) * 12 + DateMonth(zaznam.datum) - 1;
+	return ((maxMonthIndex - monthIndex) << 47) | (uint64_t)(MAX_CASTKA - zaznam.castka);
+}
+
+/**
+ * @brief Funkce seradi klice vzestupne (LSD radix sort po bajtech), indexy se presouvaji spolu s klici
+ *
+ * Razeni je stabilni, bajty, ktere maji vsechny klice stejne, se preskoci.
+ * @param keys klice k serazeni
+ * @param indexes indexy zaznamu patrici ke klicum
+ */
+void RadixSort(vector<uint64_t> &keys, vector<uint32_t> &indexes)
+{
+	size_t n = keys.size();
+	if (n < 2)
+		return;
+
+	size_t counts[8][256] = {};		// lokalni, aby funkce sla volat z vice vlaken naraz
+	for (size_t i = 0; i < n; i++)
+		for (int b = 0; b < 8; b++)
+			counts[b][(keys[i] >> (8 * b)) & 0xFF]++;
+
+	vector<uint64_t> tmpKeys(n);
+	vector<uint32_t> tmpIndexes(n);
+	for (int b = 0; b < 8; b++)
+	{
+		size_t *count = counts[b];
+		if (count[(keys[0] >> (8 * b)) & 0xFF] == n)
+			continue;		// vsechny klice maji tento bajt stejny
+
+		size_t offset = 0;
+		for (int d = 0; d < 256; d++)
+		{
+			size_t c = count[d];
+			count[d] = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < n; i++)
+		{
+			size_t pos = count[(keys[i] >> (8 * b)) & 0xFF]++;
+			tmpKeys[pos] = keys[i];
+			tmpIndexes[pos] = indexes[i];
+		}
+		keys.swap(tmpKeys);
+		indexes.swap(tmpIndexes);
+	}
+}
+
+/**
+ * @brief Funkce vybere zaznamy do html a seradi je sestupne podle roku, mesice a castky
+ *
+ * Neplatne zaznamy se odfiltruji v jednom pruchodu. Zaznamy se stejnym mesicem i castkou jsou
+ * v obracenem poradi nez v souboru, stejne jako pri drivejsim razeni vyberem maxima.
+ * @param data vektor ucetnich dat
+ * @return serazene platne zaznamy
+ */
+vector<UcetniData> SortReportData(const vector<UcetniData> &data)
+{
+	StatsTimer timer(PHASE_SORT);
+	vector<uint64_t> keys;
+	vector<uint32_t> indexes;
+	keys.reserve(data.size());
+	indexes.reserve(data.size());
+
+	for (size_t i = data.size(); i-- > 0; )		// pozpatku, aby stabilni razeni drzelo obracene poradi souboru
+	{
+		if (IsReportable(data[i]))
+		{
+			keys.push_back(ReportSortKey(data[i]));
+			indexes.push_back(i);
+		}
+	}
+	RadixSort(keys, indexes);
+
+	vector<UcetniData> sortedData;
+	sortedData.reserve(indexes.size());
+	for (size_t i = 0; i < indexes.size(); i++)
+		sortedData.push_back(data[indexes[i]]);
+	StatsCount(PHASE_SORT, sortedData.size(), 0);
+	return sortedData;
+}
+
+/**
+ * @brief Funkce spocita soucty po rocich, mesicich, kategoriich a typech jednim pruchodem serazenych dat
+ *
+ * Data jsou serazena podle mesicu, takze kazdy mesic je souvisly usek. Soucty kategorii se scitaji do pole
+ * indexovaneho ID kategorie a na konci mesice se prepisou do ReportTotals.kategorie v poradi, v jakem se
+ * kategorie v mesici poprve objevily.
+ * @param sortedData data serazena funkci SortReportData
+ * @return predpocitane soucty
+ */
+ReportTotals AggregateReport(const vector<UcetniData> &sortedData)
+{
+	StatsTimer timer(PHASE_AGGREGATE);
+	StatsCount(PHASE_AGGREGATE, sortedData.size(), 0);
+	ReportTotals totals;
+	vector<int64_t> amount(categories.names.size(), 0);	// soucty indexovane ID kategorie
+	vector<bool> usedCategory(categories.names.size(), false);
+	vector<uint32_t> category;							// ID kategorii v poradi, jak se poprve objevily
+
+	size_t i = 0;
+	while (i < sortedData.size())
+	{
+		int rok = DateYear(sortedData[i].datum);
+		int mesic = DateMonth(sortedData[i].datum);
+
+		if (totals.roky.empty() || totals.roky.back().rok != rok)
+			totals.roky.push_back({ rok, totals.mesice.size(), 0, 0, 0, 0 });
+		YearTotals &year = totals.roky.back();
+
+		MonthTotals month = { rok, mesic, i, 0, totals.kategorie.size(), 0, 0, 0 };
+		for (; i < sortedData.size() && DateYear(sortedData[i].datum) == rok && DateMonth(sortedData[i].datum) == mesic; i++)
+		{
+			const UcetniData &zaznam = sortedData[i];
+			if (zaznam.prijemVydaj == TYP_PRIJEM)
+				month.prijem += zaznam.castka;
+			else
+				month.vydaj += zaznam.castka;
+
+			if (!usedCategory[zaznam.kategorie])
 			{
-			case 0:		// case 0 for days /DD/
-				if (tmp.length() == 1 && tmp[0] != '0')  // 1 - 9 numbers only so alwazs correctDate
-				{
-					correctDate = true;
-					day = stoi(tmp);
-					completDate += 1;
-				}
-				else if (tmp.length() == 2 && tmp[0] == '0' && tmp[1] != '0')
-				{
-					if (stoi(tmp) >= 1) {
-						correctDate = true;
-						int i2 = tmp[1] - '0';
-						day = i2;
-						completDate += 1;
-						//day = stoi(tmp);
-					}
-					else
-						correctDate = false;
-				}
-				else if (tmp.length() == 2 && tmp[0] != '0')		// 00 - 30 +- 31
-				{
-					if (stoi(tmp) >= 10 && stoi(tmp) <= 31) {
-						day = stoi(tmp);
-						correctDate = true;
-						completDate += 1;
-					}
-					else {
-						correctDate = false;
-						wrongDay = true;
-					}
+				usedCategory[zaznam.kategorie] = true;
+				category.push_back(zaznam.kategorie);
+			}
+			amount[zaznam.kategorie] += zaznam.castka;
+		}
+		month.pocetZaznamu = i - month.prvniZaznam;
 
-				}
-				else if (tmp.length() > 2 || tmp.length() == 0)
-				{
-					correctDate = false;
-					wrongDay = true;
-				}
-				else
-					correctDate = false;
-				break;
+		for (size_t l = 0; l < category.size(); l++)
+		{
+			totals.kategorie.push_back({ category[l], amount[category[l]] });
+			amount[category[l]] = 0;
+			usedCategory[category[l]] = false;
+		}
+		month.pocetKategorii = category.size();
+		category.clear();
 
-			case 1:		// case 1 for months /MM/  1-12 || 01 - 12
-				if (tmp.length() == 1 && tmp[0] != '0')
-				{
-					correctDate = true;
-					month = stoi(tmp);
-					completDate += 1;
-				}
-				else if (tmp.length() == 2 && tmp[0] == '0' && tmp[1] != '0')
-				{
-					if (stoi(tmp) >= 1) {
-						correctDate = true;
-						int i2 = tmp[1] - '0';
-						month = i2;
-						completDate += 1;
-						//month = stoi(tmp);
-					}
-				}
-				else if (tmp.length() == 2 && tmp[0] != '0')
+		year.prijem += month.prijem;
+		year.vydaj += month.vydaj;
+		year.pocetMesicu++;
+		totals.mesice.push_back(month);
+	}
+	return totals;
+}
+
+/**
+ * @brief Funkce otevre docasny soubor pro html vystup
+ * @param html html writer
+ * @param path cilovy html soubor
+ * @return true pokud se docasny soubor podarilo vytvorit
+ */
+bool HtmlOpen(HtmlWriter &html, const string &path)
+{
+	html.path = path;
+	html.tmpPath = path + ".tmp";
+	html.buffer.clear();
+	html.buffer.reserve(HTML_BUFFER_SIZE + HTML_BUFFER_SIZE / 4);
+	html.failed = false;
+	html.file = fopen(html.tmpPath.c_str(), "wb");
+	if (html.file == nullptr)
+		html.failed = true;
+	return !html.failed;
+}
+
+/**
+ * @brief Funkce zapise buffer do docasneho souboru
+ * @param html html writer
+ */
+void HtmlFlush(HtmlWriter &html)
+{
+	StatsTimer timer(PHASE_HTML_WRITE);
+	StatsCount(PHASE_HTML_WRITE, 0, html.buffer.size());
+	if (!html.failed && !html.buffer.empty() && fwrite(html.buffer.data(), 1, html.buffer.size(), html.file) != html.buffer.size())
+		html.failed = true;
+	html.buffer.clear();
+}
+
+/**
+ * @brief Funkce oznaci konec sekce html, buffer se zapise na disk jen pokud uz je dost velky
+ * @param html html writer
+ */
+void HtmlSectionEnd(HtmlWriter &html)
+{
+	if (html.buffer.size() >= HTML_BUFFER_SIZE)
+		HtmlFlush(html);
+}
+
+/**
+ * @brief Funkce zapise zbytek bufferu, zavre docasny soubor a prejmenuje ho na cilovy soubor
+ * @param html html writer
+ * @return true pokud se cely soubor podarilo zapsat
+ */
+bool HtmlCommit(HtmlWriter &html)
+{
+	if (html.file == nullptr)
+		return false;
+
+	HtmlFlush(html);
+	StatsTimer timer(PHASE_HTML_WRITE);
+	if (fclose(html.file) != 0)
+		html.failed = true;
+	html.file = nullptr;
+
+	if (!html.failed)
+	{
+#ifdef _WIN32
+		html.failed = !MoveFileExA(html.tmpPath.c_str(), html.path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+		html.failed = rename(html.tmpPath.c_str(), html.path.c_str()) != 0;
+#endif
+	}
+	if (html.failed)
+		remove(html.tmpPath.c_str());
+	return !html.failed;
+}
+
+/**
+ * @brief Operator pro pridani textu do html bufferu
+ * @param html html writer
+ * @param text text
+ * @return html writer
+ */
+HtmlWriter& operator<<(HtmlWriter &html, string_view text)
+{
+	html.buffer.append(text.data(), text.size());
+	return html;
+}
+
+/**
+ * @brief Operator pro pridani cisla do html bufferu
+ * @param html html writer
+ * @param number cislo
+ * @return html writer
+ */
+HtmlWriter& operator<<(HtmlWriter &html, long long number)
+{
+	char text[24];
+	to_chars_result result = to_chars(text, text + sizeof(text), number);
+	html.buffer.append(text, result.ptr - text);
+	return html;
+}
+
+/**
+ * @brief Funkce pro vytvoreni html souboru
+ *
+ * Mesice se berou z cache vyrenderovanych mesicu (UpdateHtmlCache), znovu se renderuji jen mesice,
+ * jejichz zaznamy se od minuleho vystupu zmenily. Soucty roku se sectou ze souctu mesicu.
+ * @param data - vektor ucetnich dat
+ */
+void CreateHtml(const vector<UcetniData> &data)
+{
+	HtmlWriter htmlfile;
+	UpdateHtmlCache(data);
+	UpdateBalanceIndex(data);
+	if (HTML_PAGES != 0)
+	{
+		CreateHtmlPages();
+		return;
+	}
+
+	string htmlPath = (outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath);
+	if (!HtmlOpen(htmlfile, htmlPath))
+	{
+		cout << "Html soubor " << htmlPath << " nelze vytvorit!" << endl << endl;
+		return;
+	}
+	HtmlBegin(htmlfile);
+
+	auto it = htmlCache.months.rbegin();
+	while (it != htmlCache.months.rend())
+	{
+		YearTotals year = { (int)(it->first / 12), 0, 0, 0, 0, 0 };
+		year.zustatek = BalanceUntil(PackDate(31, 12, year.rok));
+		htmlfile << "<h2>" << year.rok << "</h2>\n";
+
+		for (; it != htmlCache.months.rend() && (int)(it->first / 12) == year.rok; ++it)
+		{
+			htmlfile << it->second.html;
+			year.prijem += it->second.prijem;
+			year.vydaj += it->second.vydaj;
+			year.pocetMesicu++;
+		}
+
+		HtmlYearTotals(htmlfile, year);
+		HtmlSectionEnd(htmlfile);
+	}
+
+	HtmlEnd(htmlfile);
+	if (!HtmlCommit(htmlfile))
+		cout << "Html soubor " << htmlPath << " se nepodarilo zapsat!" << endl << endl;
+}
+
+/**
+ * @brief Funkce vytvori html soubor z libovolnych zaznamu (napr. vysledku dotazu), bez cache a bez rozdeleni na stranky
+ * @param data ucetni data
+ * @param htmlPath cesta k html souboru
+ * @return true pokud se soubor podarilo zapsat
+ */
+bool CreateHtmlReport(const vector<UcetniData> &data, const string &htmlPath)
+{
+	HtmlWriter htmlfile;
+	if (!HtmlOpen(htmlfile, htmlPath))
+	{
+		cout << "Html soubor " << htmlPath << " nelze vytvorit!" << endl << endl;
+		return false;
+	}
+
+	vector<UcetniData> sortedData = SortReportData(data);
+	ReportTotals totals = AggregateReport(sortedData);
+	int64_t zustatek = 0;		// roky jdou od nejnovejsiho, zustatek starsiho roku je bez novejsich let
+	for (const YearTotals &year : totals.roky)
+		zustatek += year.prijem - year.vydaj;
+	HtmlBegin(htmlfile);
+	for (YearTotals &year : totals.roky)
+	{
+		year.zustatek = zustatek;
+		zustatek -= year.prijem - year.vydaj;
+		htmlfile << "<h2>" << year.rok << "</h2>\n";
+		for (size_t m = year.prvniMesic; m < year.prvniMesic + year.pocetMesicu; m++)
+			HtmlMonth(htmlfile, sortedData, totals, totals.mesice[m]);
+		HtmlYearTotals(htmlfile, year);
+		HtmlSectionEnd(htmlfile);
+	}
+	HtmlEnd(htmlfile);
+	if (!HtmlCommit(htmlfile))
+	{
+		cout << "Html soubor " << htmlPath << " se nepodarilo zapsat!" << endl << endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Funkce vytvori html vystup rozdeleny na stranky po rocich nebo mesicich (HTML_PAGES) a stranku s prehledem
+ *
+ * Prehled (cilovy html soubor) obsahuje soucty mesicu a roku a odkazy na stranky. Kazda stranka ma
+ * na prvnim radku otisk svych mesicu a zapisuje se jen tehdy, kdyz se otisk zmenil, takze pri malych
+ * zmenach dat se prepise jen prehled a stranky se zmenenymi mesici. Mesice se berou z htmlCache.
+ * Stranky mesicu a roku, ktere uz v datech nejsou, se smazou (RemoveStaleHtmlPages).
+ */
+void CreateHtmlPages()
+{
+	static const Months mnt;
+	MoneyBuffer money;
+	HtmlWriter index;
+	string htmlPath = (outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath);
+	if (!HtmlOpen(index, htmlPath))
+	{
+		cout << "Html soubor " << htmlPath << " nelze vytvorit!" << endl << endl;
+		return;
+	}
+	HtmlBegin(index);
+
+	size_t pages = 0;
+	size_t written = 0;
+	bool failed = false;
+	vector<string> pageNames;		// nazvy aktualnich stranek, ostatni stranky se smazou
+	auto it = htmlCache.months.crbegin();
+	while (it != htmlCache.months.crend())
+	{
+		int rok = it->first / 12;
+		auto yearEnd = it;
+		while (yearEnd != htmlCache.months.crend() && (int)(yearEnd->first / 12) == rok)
+			++yearEnd;
+
+		string yearPage = HtmlPagePath(htmlPath, rok, 0);
+		if (HTML_PAGES == 1)
+			index << "<h2><a href=\"" << FileName(yearPage) << "\">" << rok << "</a></h2>\n";
+		else
+			index << "<h2>" << rok << "</h2>\n";
+		index << "<table border = \"1\">\n";
+		index << "	<tr>\n";
+		index << "		<th>Mesic</th>\n";
+		index << "		<th>Prijem</th>\n";
+		index << "		<th>Vydaj</th>\n";
+		index << "		<th>Celkem</th>\n";
+		index << "		<th>Zustatek</th>\n";
+		index << "	</tr>\n";
+
+		int64_t prijem = 0;
+		int64_t vydaj = 0;
+		for (auto month = it; month != yearEnd; ++month)
+		{
+			const MonthFragment &fragment = month->second;
+			int mesic = month->first % 12 + 1;
+			string page = (HTML_PAGES == 1 ? yearPage : HtmlPagePath(htmlPath, rok, mesic));
+			index << "	<tr>\n";
+			index << "		<td><a href=\"" << FileName(page) << "\">" << mnt.nazvyMesicu[mesic - 1] << "</a></td>\n";
+			index << "		<td>" << SpacedMoneyValue(fragment.prijem, money) << "</td>\n";
+			index << "		<td>" << SpacedMoneyValue(fragment.vydaj, money) << "</td>\n";
+			index << "		<td>" << SpacedMoneyValue(fragment.prijem - fragment.vydaj, money) << "</td>\n";
+			index << "		<td>" << SpacedMoneyValue(BalanceUntil(PackDate(31, mesic, rok)), money) << "</td>\n";
+			index << "	</tr>\n";
+			prijem += fragment.prijem;
+			vydaj += fragment.vydaj;
+
+			if (HTML_PAGES == 2)
+			{
+				bool pageWritten = false;
+				auto next = month;
+				failed |= !WriteHtmlPage(page, fragment.fingerprint, month, ++next, 0, pageWritten);
+				written += pageWritten;
+				pages++;
+				pageNames.push_back(FileName(page));
+			}
+		}
+		index << "	<tr>\n";
+		index << "		<td><b>Celkem za rok</b></td>\n";
+		index << "		<td>" << SpacedMoneyValue(prijem, money) << "</td>\n";
+		index << "		<td>" << SpacedMoneyValue(vydaj, money) << "</td>\n";
+		index << "		<td>" << SpacedMoneyValue(prijem - vydaj, money) << "</td>\n";
+		index << "		<td>" << SpacedMoneyValue(BalanceUntil(PackDate(31, 12, rok)), money) << "</td>\n";
+		index << "	</tr>\n";
+		index << "</table>\n";
+
+		if (HTML_PAGES == 1)
+		{
+			uint64_t fingerprint = 0;
+			for (auto month = it; month != yearEnd; ++month)
+				fingerprint = (fingerprint ^ month->second.fingerprint ^ month->first) * 0x100000001B3ULL;
+			bool pageWritten = false;
+			failed |= !WriteHtmlPage(yearPage, fingerprint, it, yearEnd, BalanceUntil(PackDate(31, 12, rok)), pageWritten);
+			written += pageWritten;
+			pages++;
+			pageNames.push_back(FileName(yearPage));
+		}
+		it = yearEnd;
+	}
+
+	HtmlEnd(index);
+	if (!HtmlCommit(index) || failed)
+	{
+		cout << "Html soubor " << htmlPath << ", nebo nektera jeho stranka se nepodarila zapsat!" << endl << endl;
+		return;
+	}
+	size_t removed = RemoveStaleHtmlPages(htmlPath, pageNames);
+	cout << "Html prehled " << htmlPath << " vytvoren, zapsano stranek: " << written << " z " << pages;
+	if (removed != 0)
+		cout << ", smazano starych stranek: " << removed;
+	cout << endl << endl;
+}
+
+/**
+ * @brief Funkce zapise stranku html vystupu s mesici [first, last), pokud uz neexistuje se stejnym otiskem
+ * @param path cesta ke strance
+ * @param fingerprint otisk mesicu stranky
+ * @param first prvni mesic stranky (nejnovejsi)
+ * @param last konec mesicu stranky
+ * @param zustatek zustatek ke konci roku pro soucty roku (stranka na rok)
+ * @param written nastavi se na true, pokud se stranka zapisovala
+ * @return false pokud se stranku nepodarilo zapsat
+ */
+bool WriteHtmlPage(const string &path, uint64_t fingerprint, map<uint32_t, MonthFragment>::const_reverse_iterator first, map<uint32_t, MonthFragment>::const_reverse_iterator last, int64_t zustatek, bool &written)
+{
+	fingerprint = (fingerprint ^ hash<string>()(htmlCache.settings)) * 0x100000001B3ULL;	// i zmena zobrazeni meni stranku
+	fingerprint = (fingerprint ^ (uint64_t)zustatek) * 0x100000001B3ULL;		// i zmena starsich roku
+	written = false;
+	if (HtmlPageIsCurrent(path, fingerprint))
+		return true;
+
+	HtmlWriter page;
+	if (!HtmlOpen(page, path))
+		return false;
+	char header[40];
+	snprintf(header, sizeof(header), "<!-- otisk %016llx -->\n", (unsigned long long)fingerprint);
+	page << header;
+	HtmlBegin(page);
+	page << "<p><a href=\"" << FileName(outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath) << "\">Prehled</a></p>\n";
+
+	YearTotals year = { (int)(first->first / 12), 0, 0, 0, 0, zustatek };
+	page << "<h2>" << year.rok << "</h2>\n";
+	for (auto month = first; month != last; ++month)
+	{
+		page << month->second.html;
+		year.prijem += month->second.prijem;
+		year.vydaj += month->second.vydaj;
+		year.pocetMesicu++;
+	}
+	if (HTML_PAGES == 1)
+		HtmlYearTotals(page, year);
+	HtmlEnd(page);
+
+	written = true;
+	return HtmlCommit(page);
+}
+
+/**
+ * @brief Funkce zjisti, jestli stranka existuje a ma na prvnim radku stejny otisk
+ * @param path cesta ke strance
+ * @param fingerprint otisk, ktery by stranka mela mit
+ * @return true pokud stranku neni treba zapisovat
+ */
+bool HtmlPageIsCurrent(const string &path, uint64_t fingerprint)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	char line[40] = { 0 };
+	bool read = fgets(line, sizeof(line), file) != nullptr;
+	fclose(file);
+
+	char expected[40];
+	snprintf(expected, sizeof(expected), "<!-- otisk %016llx -->\n", (unsigned long long)fingerprint);
+	return read && strcmp(line, expected) == 0;
+}
+
+/**
+ * @brief Funkce vrati cestu ke strance roku nebo mesice, vedle prehledu a se jmenem podle nej (out-2018-03.html)
+ * @param htmlPath cesta k prehledu
+ * @param rok rok
+ * @param mesic mesic 1 - 12, 0 pro stranku celeho roku
+ * @return cesta ke strance
+ */
+string HtmlPagePath(const string &htmlPath, int rok, int mesic)
+{
+	string stem = htmlPath;
+	if (stem.size() >= 5 && stem.compare(stem.size() - 5, 5, ".html") == 0)
+		stem.resize(stem.size() - 5);
+
+	char suffix[24];
+	if (mesic == 0)
+		snprintf(suffix, sizeof(suffix), "-%04d.html", rok);
+	else
+		snprintf(suffix, sizeof(suffix), "-%04d-%02d.html", rok, mesic);
+	return stem + suffix;
+}
+
+/**
+ * @brief Funkce smaze stranky html vystupu (HtmlPagePath), ktere nepatri k aktualnim strankam
+ *
+ * Po smazani nebo zmene datumu zaznamu by jinak ve slozce zustaly stranky mesicu a roku, ktere
+ * uz nejsou v datech, a stejne tak stranky po prepnuti mezi strankami na rok a na mesic.
+ * @param htmlPath cesta k prehledu
+ * @param pageNames nazvy aktualnich stranek (FileName)
+ * @return pocet smazanych stranek
+ */
+size_t RemoveStaleHtmlPages(const string &htmlPath, const vector<string> &pageNames)
+{
+	string stem = HtmlPagePath(htmlPath, 0, 0);
+	stem.resize(stem.size() - strlen("-0000.html"));
+	if (stem.find_last_of("/\\") == string::npos)
+		stem.insert(0, "./");		// jen slozka prehledu, bez hledani ve slozce vstupnich dat
+
+	size_t removed = 0;
+	for (const char *mask : { "-????.html", "-????" "-??.html" })
+	{
+		for (const string &path : ListMatchingFiles(stem + mask))
+		{
+			string name = FileName(path);
+			string_view suffix = string_view(name).substr(FileName(stem).size() + 1);
+			bool digits = all_of(suffix.begin(), suffix.end() - 5, [](char c) { return isdigit((unsigned char)c) || c == '-'; });
+			if (digits && find(pageNames.begin(), pageNames.end(), name) == pageNames.end() && remove(path.c_str()) == 0)
+				removed++;
+		}
+	}
+	return removed;
+}
+
+/**
+ * @brief Funkce vrati jmeno souboru bez slozek, pro odkazy mezi strankami ve stejne slozce
+ * @param path cesta k souboru
+ * @return jmeno souboru
+ */
+string FileName(const string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return (slash == string::npos ? path : path.substr(slash + 1));
+}
+
+/**
+ * @brief Funkce vrati index mesice datumu, mesice jdou po sobe i pres hranici roku
+ * @param datum datum RRRRMMDD
+ * @return rok * 12 + mesic - 1
+ */
+uint32_t MonthIndex(uint32_t datum)
+{
+	return DateYear(datum) * 12 + DateMonth(datum) - 1;
+}
+
+/**
+ * @brief Funkce spocita hash vsech poli zaznamu, ktera se vypisuji do html
+ * @param zaznam zaznam ucetnich dat
+ * @return hash zaznamu
+ */
+uint64_t RecordHash(const UcetniData &zaznam)
+{
+	const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+	uint64_t hash = (uint64_t)zaznam.castka;
+	hash = (hash ^ (uint32_t)zaznam.ID) * multiplier;
+	hash = (hash ^ zaznam.datum) * multiplier;
+	hash = (hash ^ ((uint64_t)zaznam.kategorie << 8 | zaznam.prijemVydaj)) * multiplier;
+	return hash ^ (hash >> 31);
+}
+
+/**
+ * @brief Funkce aktualizuje cache vyrenderovanych mesicu podle dat
+ *
+ * Jednim pruchodem dat se spocita otisk kazdeho mesice (hash platnych zaznamu v poradi souboru, na kterem
+ * zavisi i poradi zaznamu se stejnou castkou). Mesice se stejnym otiskem a poctem zaznamu se vezmou z cache,
+ * ostatni se seradi a vyrenderuji znovu. Mesice, ktere v datech uz nejsou, z cache vypadnou. Pri zmene
+ * oddelovacu nebo zobrazeni haleru se cela cache zahodi.
+ * @param data vektor ucetnich dat
+ */
+void UpdateHtmlCache(const vector<UcetniData> &data)
+{
+	string settings = string(1, TIME_DELIMITER) + MONEY_DELIMITER + (MONEY_HALERE ? "h" : "");
+	if (settings != htmlCache.settings)
+	{
+		htmlCache.months.clear();
+		htmlCache.settings = settings;
+	}
+
+	map<uint32_t, MonthFragment> months;
+	auto last = months.end();		// zaznamy stejneho mesice byvaji za sebou, mapa se pak neprohledava
+	for (const UcetniData &zaznam : data)
+	{
+		if (!IsReportable(zaznam))
+			continue;
+		uint32_t monthIndex = MonthIndex(zaznam.datum);
+		if (last == months.end() || last->first != monthIndex)
+			last = months.try_emplace(monthIndex).first;
+		last->second.fingerprint = (last->second.fingerprint ^ RecordHash(zaznam)) * 0x100000001B3ULL;
+		last->second.pocetZaznamu++;
+	}
+
+	size_t dirtyCount = 0;
+	for (auto &month : months)
+	{
+		auto cached = htmlCache.months.find(month.first);
+		if (cached != htmlCache.months.end() && cached->second.fingerprint == month.second.fingerprint
+			&& cached->second.pocetZaznamu == month.second.pocetZaznamu)
+		{
+			month.second = move(cached->second);
+		}
+		else
+		{
+			month.second.dirty = true;
+			dirtyCount++;
+		}
+	}
+
+	if (dirtyCount != 0)
+	{
+		map<uint32_t, vector<UcetniData>> dirtyData;
+		for (const UcetniData &zaznam : data)
+		{
+			if (!IsReportable(zaznam))
+				continue;
+			auto month = months.find(MonthIndex(zaznam.datum));
+			if (month->second.dirty)
+				dirtyData[month->first].push_back(zaznam);
+		}
+
+		for (auto &monthData : dirtyData)
+		{
+			vector<UcetniData> sortedData = SortReportData(monthData.second);
+			ReportTotals totals = AggregateReport(sortedData);
+			HtmlWriter fragment;
+			HtmlMonth(fragment, sortedData, totals, totals.mesice[0]);
+
+			MonthFragment &month = months[monthData.first];
+			month.html.swap(fragment.buffer);
+			month.prijem = totals.mesice[0].prijem;
+			month.vydaj = totals.mesice[0].vydaj;
+			month.dirty = false;
+		}
+	}
+	htmlCache.months = move(months);
+}
+
+/**
+ * @brief Funkce vytvori html soubor primo z .csv souboru s omezenou pameti, vysledek je stejny jako u CreateHtml
+ *
+ * Jednim pruchodem souboru a za nim jeho journalu (stejne jako loadData) se platne zaznamy rozdeli do behu
+ * po mesicich (MonthRun). Kdyz pamet behu (kapacita bufferu, uzly mapy a cesty behu) prekroci
+ * STREAM_MEMORY_BUDGET, vsechny behy se pripisou na disk. Potom se mesice od nejnovejsiho nactou po jednom,
+ * seradi a vypisou, takze v pameti je vzdy jen jeden mesic. Nacitana data v pameti programu (menu 2) se nemeni.
+ * @param pathToCSV cesta k .csv souboru
+ */
+void CreateHtmlStream(string pathToCSV)
+{
+	MappedFile inputData;
+	if (!MapFile(pathToCSV, inputData))
+	{
+		cout << "Soubor nenalezen!" << endl << endl;
+		return;
+	}
+
+	string htmlPath = (outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath);
+	map<uint32_t, MonthRun> runs;		// index mesice (rok * 12 + mesic - 1) -> beh mesice
+	IdIndex idIndex;
+	ErrorLog errorLog;
+	vector<UcetniData> row;
+	vector<string_view> fields;
+	PhaseTotals totals;
+	size_t errorCount = 0;
+	size_t buffered = 0;			// pamet behu: kapacita bufferu, uzly mapy a cesty behu
+	int64_t totalBalance = 0;		// zustatek vsech platnych zaznamu, pro zustatky roku
+	bool failed = false;
+
+	auto scan = [&](const char *begin, const char *end)
+	{
+		CsvScanner scanner;
+		CsvScannerInit(scanner, begin, end);
+		while (scanner.position < scanner.end && !failed)
+		{
+			NextCsvRecord(scanner, fields);
+			if (fields.size() < 5)
+				continue;
+
+			row.clear();
+			ParseCsvFields(fields, row, errorLog, idIndex, totals);
+			errorCount += errorLog.entries.size();
+			errorLog.entries.clear();		// vypisuje se jen pocet chyb, pamet zustane omezena
+			if (!IsReportable(row[0]))
+				continue;
+			totalBalance += (row[0].prijemVydaj == TYP_PRIJEM ? row[0].castka : -row[0].castka);
+
+			uint32_t monthIndex = DateYear(row[0].datum) * 12 + DateMonth(row[0].datum) - 1;
+			auto inserted = runs.emplace(monthIndex, MonthRun());
+			MonthRun &run = inserted.first->second;
+			if (inserted.second)
+				buffered += sizeof(*inserted.first) + 4 * sizeof(void*);		// uzel mapy: zaznam, 3 ukazatele a barva
+			size_t capacity = run.buffer.capacity();
+			run.buffer.push_back(row[0]);
+			buffered += (run.buffer.capacity() - capacity) * sizeof(UcetniData);
+
+			if (buffered >= STREAM_MEMORY_BUDGET)
+			{
+				buffered = 0;
+				for (auto &r : runs)
 				{
-					if (stoi(tmp) >= 10 && stoi(tmp) <= 12) {
-						correctDate = true;
-						month = stoi(tmp);
-						completDate += 1;
-					}
-					else
-					{
-						correctDate = false;
-						wrongMonth = true;
-					}
-				}
-				else {
-					correctDate = false;
+					if (r.second.path.empty())
+						r.second.path = htmlPath + ".run" + to_string(r.first);
+					if (!SpillMonthRun(r.second))
+						failed = true;
+					buffered += sizeof(r) + 4 * sizeof(void*) + r.second.path.capacity();		// zustava i po zapisu
 				}
-				break;
+			}
+		}
+	};
+	scan(inputData.data, inputData.data + inputData.size);
+	UnmapFile(inputData);
+
+	// rucne pridane zaznamy, stejne jako pri nacteni do pameti (ReplayJournal)
+	string journalPath = pathToCSV + ".journal";
+	if (journal.path == journalPath)
+		JournalClose(journal);		// pridane zaznamy musi byt na disku, dalsi zapis journal znovu otevre
+	MappedFile journalData;
+	if (!failed && MapFile(journalPath, journalData))
+	{
+		size_t length = journalData.size;
+		while (length > 0 && journalData.data[length - 1] != '\n')
+			length--;		// neuplny posledni radek se ignoruje
+		scan(journalData.data, journalData.data + length);
+		UnmapFile(journalData);
+	}
+	StatsMerge(totals);
+
+	HtmlWriter htmlfile;
+	if (!failed && !HtmlOpen(htmlfile, htmlPath))
+	{
+		cout << "Html soubor " << htmlPath << " nelze vytvorit!" << endl << endl;
+		failed = true;
+	}
 
-			default:
+	if (!failed)
+	{
+		HtmlBegin(htmlfile);
+		YearTotals year = { 0, 0, 0, 0, 0, 0 };
+		int64_t zustatek = totalBalance;		// roky jdou od nejnovejsiho, zustatek starsiho roku je bez novejsich let
+		vector<UcetniData> monthData;
+		for (auto it = runs.rbegin(); it != runs.rend() && !failed; ++it)
+		{
+			if (!ReadMonthRun(it->second, monthData))
+			{
+				failed = true;
 				break;
 			}
+			vector<UcetniData> sortedData = SortReportData(monthData);
+			ReportTotals totals = AggregateReport(sortedData);
+			const MonthTotals &month = totals.mesice[0];
 
-			/*if (tmp.length() < 2) {
-				tmp = '0' + tmp;
+			if (year.pocetMesicu != 0 && year.rok != month.rok)
+			{
+				HtmlYearTotals(htmlfile, year);
+				HtmlSectionEnd(htmlfile);
+				zustatek -= year.prijem - year.vydaj;
+				year = { 0, 0, 0, 0, 0, 0 };
 			}
-			newTime.push_back(tmp);*/
-
-			pos = i + 1;
-			numberOfDelimiters++;
-		}
-		else if (numberOfDelimiters == 2)		// case for years /YYYY/ , only 1582 - 9999 years allowed
-		{
-			if (i < time.size() - 1) {
-				year = stoi(time.substr(pos, time.size() - 1));
-
-				if (year >= 1582 && year <= 9999) {
-					correctDate = true;
-					completDate += 1;
-					break;
-				}
-				else
-				{
-					// spatny rok
-					correctDate = false;
-					break;
-				}
-		//newTime.push_back(time.substr(pos, time.size() - 1));
+			if (year.pocetMesicu == 0)
+			{
+				year.rok = month.rok;
+				year.zustatek = zustatek;
+				htmlfile << "<h2>" << year.rok << "</h2>\n";
 			}
-		//break;
-		}
-		else {
-			//correctDate = false; // nepouzivat! vsechny casy se daji na "spatny datum"
+			HtmlMonth(htmlfile, sortedData, totals, month);
+			year.prijem += month.prijem;
+			year.vydaj += month.vydaj;
+			year.pocetMesicu++;
 		}
+		if (year.pocetMesicu != 0)
+			HtmlYearTotals(htmlfile, year);
+		HtmlEnd(htmlfile);
+		if (!failed && !HtmlCommit(htmlfile))
+			failed = true;
 	}
 
-	if (correctDate && completDate == 3)
+	for (auto &r : runs)
 	{
-		int correctDay;
-		correctDay = m.NumOFDays(month, year);
-
-		if (day <= correctDay)
+		if (r.second.spilled != 0)
+			remove(r.second.path.c_str());
+	}
+	if (failed)
+	{
+		if (htmlfile.file != nullptr)
 		{
-			// spravny datum
-			string strDay, strMonth, strYear;
+			fclose(htmlfile.file);
+			remove(htmlfile.tmpPath.c_str());
+		}
+		cout << "Html soubor " << htmlPath << " se nepodarilo zapsat!" << endl << endl;
+	}
+	else
+		cout << "Html soubor " << htmlPath << " vytvoren, pocet chyb ve vstupnim souboru: " << errorCount << endl << endl;
+}
 
-			if (to_string(day).length() < 2)
-				strDay = "0" + to_string(day);
-			else
-				strDay = to_string(day);
-			if (to_string(month).length() < 2)
-				strMonth = "0" + to_string(month);
-			else
-				strMonth = to_string(month);
+/**
+ * @brief Funkce pripise zaznamy behu mesice z pameti na konec jeho souboru na disku
+ * @param run beh mesice
+ * @return true pokud se zapis podaril
+ */
+bool SpillMonthRun(MonthRun &run)
+{
+	if (run.buffer.empty())
+		return true;
 
-			strYear = to_string(year);
+	FILE *file = fopen(run.path.c_str(), "ab");
+	if (file == nullptr)
+		return false;
+	bool ok = fwrite(run.buffer.data(), sizeof(UcetniData), run.buffer.size(), file) == run.buffer.size();
+	if (fclose(file) != 0)
+		ok = false;
 
-			values[overallRows].day = strDay;
-			values[overallRows].month = strMonth;
-			values[overallRows].year = strYear;
-			//time = strDay + TIME_DELIMITER + strMonth + TIME_DELIMITER + strYear;
-		}
-		else {
-			// Nespravny datum, kvuli prestupnemu roku
-			time = "x";
-			errorText.id.push_back(id);
-			errorText.info.push_back("Neplatny rok --> prestupny rok");
-			//to_string(overallRows) + " - Neplatny rok --> prestupny rok";
-		}
-	}
-	else if (!correctDate && completDate == 3)
+	run.spilled += run.buffer.size();
+	run.buffer.clear();
+	run.buffer.shrink_to_fit();
+	return ok;
+}
+
+/**
+ * @brief Funkce nacte vsechny zaznamy behu mesice (z disku i z pameti) v poradi souboru
+ * @param run beh mesice, jeho pamet se uvolni
+ * @param data sem se ulozi zaznamy mesice
+ * @return true pokud se beh podarilo nacist
+ */
+bool ReadMonthRun(MonthRun &run, vector<UcetniData> &data)
+{
+	data.resize(run.spilled);
+	if (run.spilled != 0)
 	{
-		time = "x";
-		errorText.id.push_back(id);
-		errorText.info.push_back("Nespravne zadane datum.");
-		//numOfErrorLines += 1;
-		//ERROR_TEXT[numOfErrorLines] = "ID: " + to_string(overallRows) + " - Nespravne zadane datum";
-	}
-	else if (wrongDay) {
-		time = "x";
-		errorText.id.push_back(id);
-		errorText.info.push_back("Neplatny rok --> Nespravne zadany den");
-		//ERROR_TEXT[numOfErrorLines] = "ID: " + to_string(overallRows) + " - Neplatny rok --> Nespravne zadany den";
-		//time = "Nespravne zadany den";
+		FILE *file = fopen(run.path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+		bool ok = fread(data.data(), sizeof(UcetniData), run.spilled, file) == run.spilled;
+		fclose(file);
+		if (!ok)
+			return false;
 	}
-	else if (wrongMonth)
+	data.insert(data.end(), run.buffer.begin(), run.buffer.end());
+	vector<UcetniData>().swap(run.buffer);
+	return true;
+}
+
+/**
+ * @brief Funkce zapise zacatek html souboru
+ * @param htmlfile html writer
+ */
+void HtmlBegin(HtmlWriter &htmlfile)
+{
+	htmlfile << "<!DOCTYPE html>\n<html>\n";
+	htmlfile << "<head>\n<title>Ucetnictvi</title>\n</head>\n";
+	htmlfile << "<body>\n";
+	htmlfile << "<h1>Domaci ucetnictvi</h1>\n";
+}
+
+/**
+ * @brief Funkce zapise do html jeden mesic: zaznamy, soucty kategorii a soucet mesice
+ * @param htmlfile html writer
+ * @param sortedData serazena data, do kterych ukazuje month
+ * @param totals soucty, do kterych ukazuje month
+ * @param month mesic k vypsani
+ */
+void HtmlMonth(HtmlWriter &htmlfile, const vector<UcetniData> &sortedData, const ReportTotals &totals, const MonthTotals &month)
+{
+	StatsTimer timer(PHASE_HTML_RENDER);
+	StatsCount(PHASE_HTML_RENDER, month.pocetZaznamu, 0);
+	static const Months mnt;
+	MoneyBuffer money;
+
+	htmlfile << "<h3><i><b>" << mnt.nazvyMesicu[month.mesic - 1] << "</b></i></h3>\n";
+	htmlfile << "<p>Serazeno dle nejvyssi castky</p>";
+	htmlfile << "<table border = \"1\">\n";
+	htmlfile << "	<tr>\n";
+	htmlfile << "		<th>ID</th>\n";
+	htmlfile << "		<th>Typ</th>\n";
+	htmlfile << "		<th>Kategorie</th>\n";
+	htmlfile << "		<th>Castka [Kc]</th>\n";
+	htmlfile << "		<th>Datum</th>\n";
+	htmlfile << "	</tr>\n";
+
+	for (size_t i = month.prvniZaznam; i < month.prvniZaznam + month.pocetZaznamu; i++)
 	{
-		time = "x";
-		errorText.id.push_back(id);
-		errorText.info.push_back("Neplatny rok --> Nespravne zadany mesic");
-		//ERROR_TEXT[numOfErrorLines] = "ID: " + to_string(overallRows) + " - Neplatny rok --> Nespravne zadany mesic";
-		//time = "Nespravne zadany mesic";
+		string date = DateText(sortedData[i].datum);
+		htmlfile << "	<tr>\n";
+		htmlfile << "		<td>" << sortedData[i].ID << "</td>\n";
+		htmlfile << "		<td>" << TypeText(sortedData[i].prijemVydaj) << "</td>\n";
+		htmlfile << "		<td>" << CategoryText(sortedData[i].kategorie) << "</td>\n";
+		htmlfile << "		<td>" << SpacedMoneyValue(sortedData[i].castka, money) << "</td>\n";
+		htmlfile << "		<td>" << date << "</td>\n";
+		htmlfile << "	</tr>\n";
 	}
-	else if (year == NULL)
+	htmlfile << "</table>\n\n";
+	htmlfile << "<p><b>Celkem za mesic</b></p>";
+	htmlfile << "<table border = \"1\">\n";
+	htmlfile << "	<tr>\n";
+	for (size_t l = month.prvniKategorie; l < month.prvniKategorie + month.pocetKategorii; l++)
 	{
-		time = "x";
-		errorText.id.push_back(id);
-		errorText.info.push_back("Neplatny rok --> Chybi datum");
-		//ERROR_TEXT[numOfErrorLines] = "ID: " + to_string(overallRows) + " - Neplatny rok --> Chybi datum";
-		//time = "Chybi datum";
+		if (totals.kategorie[l].castka != 0)
+			htmlfile << "		<th>" << CategoryText(totals.kategorie[l].kategorie) << "</th>\n";
 	}
-	else
+	htmlfile << "	</tr>\n";
+	htmlfile << "	<tr>\n";
+	for (size_t l = month.prvniKategorie; l < month.prvniKategorie + month.pocetKategorii; l++)
 	{
-		time = "x";
-		errorText.id.push_back(id);
-		errorText.info.push_back("Nespravne zadane datum.");
-		//ERROR_TEXT[numOfErrorLines] = "ID: " + to_string(overallRows) + " - Nespravne zadane datum";
-		//time = "Nespravne zadane datum";
+		if (totals.kategorie[l].castka != 0)
+			htmlfile << "		<td>" << SpacedMoneyValue(totals.kategorie[l].castka, money) << "</td>\n";
 	}
+	htmlfile << "	</tr>\n";
+	htmlfile << "</table>\n";
+	htmlfile << "<br>\n";
+	htmlfile << "<table border = \"1\">\n";
+	htmlfile << "	<tr>\n";
+	htmlfile << "		<th>Prijem</th>\n";
+	htmlfile << "		<th>Vydaj</th>\n";
+	htmlfile << "		<th>Celkem</th>\n";
+	htmlfile << "	</tr>\n";
+	htmlfile << "	<tr>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(month.prijem, money) << "</td>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(month.vydaj, money) << "</td>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(month.prijem - month.vydaj, money) << "</td>\n";
+	htmlfile << "	</tr>\n";
+	htmlfile << "</table>\n";
 }
 
 /**
- * @brief Funkce ktera zkousi prevest string na int, nebo double
- * @param num - zadany string pro prevod
- * @param c parametr pro c = 0 znaci prevod stringu na int, c = 3 prevod stringu na double
- * @return true, pokus lze string prevest na cislo, false pokud nelze
+ * @brief Funkce zapise do html soucet roku
+ * @param htmlfile html writer
+ * @param year soucty roku
  */
-bool TryConvertFromString(string num, int c)
+void HtmlYearTotals(HtmlWriter &htmlfile, const YearTotals &year)
 {
-	//int x;
-	//double y;
+	MoneyBuffer money;
 
-	try {
-		// do stuff that may throw or fail
-		if(c == 0)
-			stoi(num);
-		else if (c == 3)
-			stod(num);
-	}
-	catch (invalid_argument& e) {
-		// if no conversion could be performed
-		//cerr << "Invalid argument error: " << e.what() << endl;
-		return false;
-	}
-	catch (out_of_range& ex) {
-		// if the converted value would fall out of the range of the result type
-		// or if the underlying function (std::strtol or std::strtoull) sets errno
-		// to ERANGE.
-		//cerr << "Error - out of range: " << ex.what() << endl;
-		return false;
+	htmlfile << "<p><b>Celkem za rok</b></p>";
+	//htmlfile << "<br>\n";
+	htmlfile << "<table border = \"1\">\n";
+	htmlfile << "	<tr>\n";
+	htmlfile << "		<th>Prijem</th>\n";
+	htmlfile << "		<th>Vydaj</th>\n";
+	htmlfile << "		<th>Celkem</th>\n";
+	htmlfile << "		<th>Zustatek</th>\n";
+	htmlfile << "	</tr>\n";
+	htmlfile << "	<tr>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(year.prijem, money) << "</td>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(year.vydaj, money) << "</td>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(year.prijem - year.vydaj, money) << "</td>\n";
+	htmlfile << "		<td>" << SpacedMoneyValue(year.zustatek, money) << "</td>\n";
+	htmlfile << "	</tr>\n";
+	htmlfile << "</table>\n";
+}
+
+/**
+ * @brief Funkce zapise konec html souboru
+ * @param htmlfile html writer
+ */
+void HtmlEnd(HtmlWriter &htmlfile)
+{
+	//ending html
+	htmlfile << "</tbody>\n";
+	htmlfile << "</body>\n</html>";
+}
+
+#ifdef BENCHMARK
+/*
+ * Benchmark (cil Benchmark v domaci_ucetnictvi.cbp, preklad s -DBENCHMARK).
+ *
+ * benchmark [maxRows] [badDate% duplicateId% badMoney% emptyField%]
+ *     zmeri loadData, LoadLedgers, TimeFormat, CheckMoney, SpacedMoneyValue a CreateHtml pro 1K, 10K, ... maxRows radku
+ *     a u kazde velikosti vypise, kolik zaznamu se prijalo (jeden soubor prijme nejvys MAX_ID + 1 zaznamu,
+ *     knihy po MAX_ID + 1 radcich s ID podle souboru prijmou vsechny platne radky)
+ * benchmark --generate rows file [badDate% duplicateId% badMoney% emptyField%]
+ *     jen vygeneruje .csv soubor
+ * benchmark --check
+ *     kontroly, ktere se mereni netykaji (zaznamy pridane do journalu se po restartu nactou stejne, i u vice knih,
+ *     zustatky z indexu odpovidaji prostemu souctu)
+ */
+
+atomic<size_t> allocationCount(0);	/*!< pocet alokaci pres operator new */
+atomic<size_t> allocationBytes(0);	/*!< pocet alokovanych bajtu pres operator new */
+
+/**
+ * @brief Operator new, ktery pocita alokace pro benchmark
+ * @param size velikost alokace
+ * @return alokovana pamet
+ */
+void* operator new(size_t size)
+{
+	allocationCount++;
+	allocationBytes += size;
+	void *memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr)
+		throw bad_alloc();
+	return memory;
+}
+
+/**
+ * @brief Operator delete k pocitajicimu operator new
+ *
+ * Nesmi se vlozit (noinline), jinak gcc hlasi free na pameti z new (-Wmismatched-new-delete).
+ * @param memory pamet k uvolneni
+ */
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+
+/**
+ * @brief Operator delete s velikosti k pocitajicimu operator new
+ * @param memory pamet k uvolneni
+ */
+void operator delete(void *memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+/** @struct GeneratorMix
+ *  @brief Podil chybnych poli generovanych dat v procentech, chyby jsou stejneho druhu jako ve vstupnidata/data.csv.
+ */
+struct GeneratorMix
+{
+	int badDate = 5;		/*!< neplatne datum (31.02., 13. mesic, prestupny rok, chybejici rok) */
+	int duplicateId = 5;	/*!< ID, ktere uz bylo pouzito */
+	int badMoney = 5;		/*!< castka, ktera neni cislo, nebo je zaporna */
+	int emptyField = 5;		/*!< jedno prazdne pole */
+};
+
+/** @struct BenchRandom
+ *  @brief Deterministicky generator nahodnych cisel (xorshift64*), stejne seminko dava stejna data.
+ */
+struct BenchRandom
+{
+	uint64_t state;		/*!< stav generatoru, nesmi byt 0 */
+
+	uint64_t Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1DULL;
 	}
-	catch (...) {
-		// catch any other errors (that we have no information about),everything else
-		//cerr << "Unknown failure occurred." << endl;
-		return false;
+
+	int Below(int limit)
+	{
+		return (int)(Next() % (uint64_t)limit);
 	}
-	return true;
-}
+};
 
 /**
- * @brief Funkce, ktera kontroluje spravnost ID
- * @param strId - strId je id k porovnani
- * @param ucetniData - data k porovnani s strId
- * @return true, pokud id neni obsazen v ucetnich datech, false ze uz tam je obsazen
+ * @brief Funkce vygeneruje .csv soubor s rows radky a chybami podle mix
+ *
+ * ID jdou po sobe, po MAX_ID zacinaji znovu od 0 (vetsi ID format neumoznuje), takze radky nad MAX_ID + 1
+ * jsou vzdy duplicitni. Vic platnych zaznamu daji jen knihy po MAX_ID + 1 radcich (GenerateLedgers).
+ * @param path cesta k souboru
+ * @param rows pocet radku
+ * @param mix podil chybnych poli
+ * @param seed seminko generatoru
+ * @return pocet zapsanych bajtu, 0 pri chybe
  */
-bool IsValidID(string strId, vector<UcetniData> ucetniData, ErrorText &errorText)
+size_t GenerateCsv(const string &path, size_t rows, const GeneratorMix &mix, uint64_t seed)
 {
-	bool isNumber;
-	int id;
-	isNumber = TryConvertFromString(strId);
+	static const char *kategorie[] = { "jidlo", "bydleni", "prace", "mzda", "zabava", "internet", "koupe", "prodej",
+		"Jidlo", "koupe nemovitosti", "antena", "lustr", "koberec", "televize", " doprava ", "obleceni" };
+	static const char *badDates[] = { "31.02.2018", "29.2.2019", "22.13.2020", "36.1.2019", "7.1-201", "29:2-2005", "000.00.2020", "" };
+	static const char *badMoney[] = { "abc", "c100", "-7000", "x", "99999999999999999" };
+	static const char delimiters[] = { '.', '-', ':' };
 
-	if (isNumber)
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return 0;
+
+	BenchRandom random = { seed != 0 ? seed : 1 };
+	string buffer;
+	size_t bytes = 0;
+	char field[5][48];
+	for (size_t i = 0; i < rows; i++)
 	{
-		id = stoi(strId);
-		if (IsIdDuplicated(id, ucetniData))
+		int id = (int)(i % (MAX_ID + 1));
+		if (random.Below(100) < mix.duplicateId && i != 0)
+			id = random.Below((int)min(i, (size_t)MAX_ID));
+		snprintf(field[0], sizeof(field[0]), "%d", id);
+		snprintf(field[1], sizeof(field[1]), "%s", random.Below(10) < 3 ? "prijem" : "vydaj");
+		snprintf(field[2], sizeof(field[2]), "%s", kategorie[random.Below(sizeof(kategorie) / sizeof(kategorie[0]))]);
+
+		if (random.Below(100) < mix.badMoney)
+			snprintf(field[3], sizeof(field[3]), "%s", badMoney[random.Below(sizeof(badMoney) / sizeof(badMoney[0]))]);
+		else if (random.Below(4) == 0)
+			snprintf(field[3], sizeof(field[3]), "%d.%02d", random.Below(100000), random.Below(100));
+		else
+			snprintf(field[3], sizeof(field[3]), "%d", 1 + random.Below(100000));
+
+		if (random.Below(100) < mix.badDate)
+			snprintf(field[4], sizeof(field[4]), "%s", badDates[random.Below(sizeof(badDates) / sizeof(badDates[0]))]);
+		else
 		{
-			// error message --> duplicated IDs not allowed
-			return false;
+			char delimiter = delimiters[random.Below(3)];
+			snprintf(field[4], sizeof(field[4]), "%02d%c%02d%c%d", 1 + random.Below(28), delimiter, 1 + random.Below(12), delimiter, 2000 + random.Below(25));
 		}
-		else if (id > 9999 || id < -1)
+
+		if (random.Below(100) < mix.emptyField)
+			field[random.Below(5)][0] = '\0';
+
+		for (int f = 0; f < 5; f++)
 		{
-			// error message --> ID is too low or too big
-            errorText.id.push_back(id);
-			errorText.info.push_back(id > 9999 ? "ID je vetsi jak 9999" : "ID je zaporne");
-			return false;
+			buffer += field[f];
+			buffer += (f < 4 ? DELIMITER : '\n');
 		}
-		else
+		if (buffer.size() >= (1 << 20))
 		{
-			return true;
+			bytes += fwrite(buffer.data(), 1, buffer.size(), file);
+			buffer.clear();
 		}
 	}
-	else
+	bytes += fwrite(buffer.data(), 1, buffer.size(), file);
+	if (fclose(file) != 0)
+		return 0;
+	return bytes;
+}
+
+/**
+ * @brief Funkce vygeneruje rows radku jako nekolik knih po MAX_ID + 1 radcich, kazda kniha ma ID od 0
+ *
+ * Pri nacteni s ID podle souboru (ID_CONFLICTS 1) se tak neodmitne zadny radek kvuli duplicite mezi knihami.
+ * @param stem zacatek nazvu souboru, kniha f je <stem>_f.csv
+ * @param rows pocet radku vsech knih, nejvic MAX_INPUT_FILES * (MAX_ID + 1)
+ * @param mix podil chybnych poli
+ * @param seed seminko generatoru
+ * @param paths sem se ulozi cesty ke kniham
+ * @return pocet zapsanych bajtu, 0 pri chybe
+ */
+size_t GenerateLedgers(const string &stem, size_t rows, const GeneratorMix &mix, uint64_t seed, vector<string> &paths)
+{
+	size_t bytes = 0;
+	paths.clear();
+	for (size_t first = 0; first < rows; first += MAX_ID + 1)
 	{
-		// error message --> ID is not a number
-		return false;
+		if (paths.size() == MAX_INPUT_FILES)
+			return 0;
+		paths.push_back(stem + "_" + to_string(paths.size()) + ".csv");
+		size_t written = GenerateCsv(paths.back(), min(rows - first, (size_t)MAX_ID + 1), mix, seed + paths.size());
+		if (written == 0)
+			return 0;
+		bytes += written;
 	}
+	return bytes;
 }
 
 /**
- * @brief Funkce, ktera kontroluje duplicitni ID
- * @param id - id ke kontrole
- * @param ucetniData - data k porovnani s id
- * @return true, pokud id neni duplicitni s ostatnima id v ucetnichDatech, false pokud se jiz stejne id vyskytuje
+ * @brief Funkce spocita zaznamy, ktere se vypisou do html (prijate radky)
+ * @param data ucetni data
+ * @return pocet platnych zaznamu (IsReportable)
+ */
+size_t CountReportable(const vector<UcetniData> &data)
+{
+	return count_if(data.begin(), data.end(), IsReportable);
+}
+
+/**
+ * @brief Funkce vypise jeden radek vysledku benchmarku
+ * @param name nazev mereni
+ * @param rows pocet zpracovanych radku
+ * @param bytes pocet zpracovanych bajtu, 0 pokud se nemeri
+ * @param seconds cas v sekundach
+ * @param allocations pocet alokaci
+ * @param allocated pocet alokovanych bajtu
+ */
+void PrintBenchResult(const char *name, size_t rows, size_t bytes, double seconds, size_t allocations, size_t allocated)
+{
+	double safeSeconds = max(seconds, 1e-9);
+	printf("%-22s %10zu %10.3f %12.0f %9.1f %12zu %12zu\n", name, rows, seconds * 1000, rows / safeSeconds,
+		bytes != 0 ? bytes / safeSeconds / (1 << 20) : 0.0, allocations, allocated);
+}
+
+/**
+ * @brief Funkce zmeri volani funkce a vypise vysledek
+ * @param name nazev mereni
+ * @param rows pocet zpracovanych radku
+ * @param bytes pocet zpracovanych bajtu, 0 pokud se nemeri
+ * @param work merena funkce
+ */
+template <typename Work>
+void Measure(const char *name, size_t rows, size_t bytes, Work work)
+{
+	size_t count = allocationCount;
+	size_t allocated = allocationBytes;
+	auto start = chrono::steady_clock::now();
+	work();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	PrintBenchResult(name, rows, bytes, seconds, allocationCount - count, allocationBytes - allocated);
+}
+
+/**
+ * @brief Funkce prida zaznam pres AddData, odpovedi na jeji otazky se ctou z textu misto z klavesnice
+ * @param ucetniData nactena data
+ * @param idIndex index obsazenych ID
+ * @param input odpovedi (typ, popis, castka), kazda na svem radku
+ */
+void AddDataFromText(vector<UcetniData> &ucetniData, IdIndex &idIndex, const string &input)
+{
+	istringstream in(input);
+	ostringstream out;
+	streambuf *oldIn = cin.rdbuf(in.rdbuf());
+	streambuf *oldOut = cout.rdbuf(out.rdbuf());
+	AddData(ucetniData, idIndex);
+	cin.rdbuf(oldIn);
+	cout.rdbuf(oldOut);
+}
+
+/**
+ * @brief Funkce porovna dve ucetni data zaznam po zaznamu, kategorie podle textu
+ * @param a prvni data
+ * @param b druha data
+ * @return true pokud jsou zaznamy stejne a ve stejnem poradi
  */
-bool IsIdDuplicated(int id, vector<UcetniData> ucetniData)
+bool SameRecords(const vector<UcetniData> &a, const vector<UcetniData> &b)
 {
-	for (unsigned int i = 0; i < ucetniData.size(); i++)
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++)
 	{
-		if (id == ucetniData[i].ID)
-			return true;
+		if (a[i].ID != b[i].ID || a[i].datum != b[i].datum || a[i].prijemVydaj != b[i].prijemVydaj || a[i].castkaPlatna != b[i].castkaPlatna
+			|| (a[i].castkaPlatna && a[i].castka != b[i].castka) || CategoryText(a[i].kategorie) != CategoryText(b[i].kategorie))
+			return false;
 	}
-	return false;
+	return true;
 }
 
 /**
- * @brief Funkce pro kontrolu, jestli vstup obsahuje "prijem", nebo "vydaj"
- * @param category string pro zkontrolovani
- * @return vraci true, pokud je category "prijem", nebo "vydaj", jinak vraci "x"
+ * @brief Kontrola: zaznamy pridane pres AddData se po restartu (prehrani journalu) nactou stejne
+ *
+ * Soubor ma obsazena vsechna ID krome 5 a 7, dalsi pridani se uz musi odmitnout a nic nezapsat.
+ * Pridane radky musi byt v journalu hned po navratu z AddData, jeste pred JournalClose.
+ * @return true pokud kontrola prosla
  */
-string CheckIncomeExpenditure(string category)
+bool CheckJournalReplay()
 {
-	transform(category.begin(), category.end(), category.begin(), ::tolower);
-	if (category == "prijem" || category == "vydaj")
+	string path = "check_journal.csv";
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	for (int id = 0; id <= MAX_ID; id++)
 	{
-		return category;
+		if (id != 5 && id != 7)
+			fprintf(file, "%d,prijem,jidlo,100,1.1.2018\n", id);
 	}
-	else
+	fclose(file);
+	remove((path + ".snap").c_str());
+	remove((path + ".journal").c_str());
+
+	vector<UcetniData> data;
+	ErrorLog errorLog;
+	IdIndex idIndex;
+	data = loadData(path, errorLog, idIndex);
+	AddDataFromText(data, idIndex, "1\nvyplata\n1500.50\n");
+	AddDataFromText(data, idIndex, "2\nnajem, voda\n900\n");
+	size_t added = data.size();
+	AddDataFromText(data, idIndex, "1\nnavic\n10\n");		// zadne volne ID
+
+	// AddData se vraci az po fsync, radky musi byt v souboru jeste pred JournalClose
+	MappedFile written;
+	size_t writtenLines = 0;
+	if (MapFile(path + ".journal", written))
 	{
-		return "x";
+		writtenLines = count(written.data, written.data + written.size, '\n');
+		UnmapFile(written);
 	}
+	JournalClose(journal);
+
+	bool ok = added == MAX_ID + 1 && data.size() == added && data[added - 2].ID == 5 && data[added - 1].ID == 7 && writtenLines == 2;
+	vector<UcetniData> replayed;
+	ErrorLog replayErrors;
+	IdIndex replayIds;
+	replayed = loadData(path, replayErrors, replayIds);		// restart: snapshot souboru a prehrani journalu
+	ok = ok && SameRecords(data, replayed) && replayErrors.entries.empty() && FreeId(replayIds) == -1;
+	JournalClose(journal);
+
+	remove(path.c_str());
+	remove((path + ".snap").c_str());
+	remove((path + ".journal").c_str());
+	printf("%-40s %s\n", "journal po restartu", ok ? "OK" : "CHYBA");
+	return ok;
 }
 
 /**
- * @brief Funkce pro vypis chyb
- * @param errorText je struktura s ulozenyma chybama
+ * @brief Kontrola: po nacteni dvou souboru se stejnymi ID (ID podle souboru) dostane pridany zaznam
+ * volne ID 0 - MAX_ID a po restartu se obe knihy i s journalem nactou stejne
+ * @return true pokud kontrola prosla
  */
-void PrintErrors(ErrorText &errorText)
+bool CheckLedgerReplay()
 {
-	cout << "Info:" << endl;
-	cout << "Duplicitni ID jsou zaznamenana jako \"-1\". Prazdne, ci neplatne vyplnene pole jsou \"x\"." << endl;
-	cout << "Radek, ktery obsahuje duplicitni ID, prazdne, ci nespravne vyplnene pole,\nnebude do html vypsan!" << endl << endl;
-	cout << "Error list:" << endl;
-	if (errorText.id.size() == 0)
-		cout << "No Errors" << endl;
-	else
+	vector<string> paths = { "check_ledger_a.csv", "check_ledger_b.csv" };
+	for (size_t f = 0; f < paths.size(); f++)
 	{
-		for (unsigned int x = 0; x < errorText.id.size(); x++)
-			cout << "Id: " << errorText.id[x] << "\t" << errorText.info[x] << endl;
+		FILE *file = fopen(paths[f].c_str(), "wb");
+		if (file == nullptr)
+			return false;
+		for (int id = 0; id < 4; id++)
+			fprintf(file, "%d,vydaj,soubor %zu,%d,%d.3.2018\n", id, f, 100 + id, 10 * (int)f + id + 1);
+		fclose(file);
 	}
-	cout << "---------------------------------------------------------------------------------------" << endl;
-	cout << endl;
+	remove((paths[0] + ".journal").c_str());
+	int oldConflicts = ID_CONFLICTS;
+	ID_CONFLICTS = 1;
+	inputFiles = paths;
+
+	vector<UcetniData> data;
+	ErrorLog errorLog;
+	IdIndex idIndex;
+	data = LoadLedgers(paths, errorLog, idIndex);
+	AddDataFromText(data, idIndex, "1\nvyplata\n2000\n");
+	JournalClose(journal);
 
-	//errorText.id.clear();
-	//errorText.info.clear();
+	int added = data.back().ID;
+	bool ok = data.size() == 9 && added >= 0 && added <= MAX_ID && IsIdDuplicated(NamespacedId(3, 1), idIndex);
+	for (size_t i = 0; i + 1 < data.size(); i++)
+		ok = ok && data[i].ID != added;
+	vector<UcetniData> replayed;
+	ErrorLog replayErrors;
+	IdIndex replayIds;
+	replayed = LoadLedgers(paths, replayErrors, replayIds);		// restart: obe knihy a prehrani journalu
+	ok = ok && SameRecords(data, replayed) && replayErrors.entries.empty();
+	JournalClose(journal);
+
+	ID_CONFLICTS = oldConflicts;
+	inputFiles.clear();
+	for (const string &path : paths)
+		remove(path.c_str());
+	remove((paths[0] + ".journal").c_str());
+	printf("%-40s %s\n", "vice knih a journal po restartu", ok ? "OK" : "CHYBA");
+	return ok;
 }
 
 /**
- * @brief Funkce pro vytvoreni html souboru
- * @param data - vektor ucetnich dat
+ * @brief Kontrola: zustatky z indexu (BalanceUntil) jsou stejne jako prosty soucet zaznamu
+ *
+ * Data zacinaji prvnim dnem stromu a maji zaznamy ve dnech 2^k, takze strom se pri sestaveni
+ * i pri pridavani po jednom zaznamu nekolikrat zdvojnasobi.
+ * @return true pokud kontrola prosla
  */
-void CreateHtml(vector<UcetniData> data)
+bool CheckBalanceIndex()
 {
-	ofstream htmlfile;
-	Months mnt;
-	vector<UcetniData> sortedData;
+	BenchRandom random = { 1582 };
+	uint32_t kategorie = InternCategory("zustatek", categories);
+	vector<uint32_t> dates = { BALANCE_EPOCH_YEAR * 10000 + 101 };
+	for (int i = 0; i < 3000; i++)
+		dates.push_back((BALANCE_EPOCH_YEAR + random.Below(600)) * 10000 + (1 + random.Below(12)) * 100 + 1 + random.Below(28));
+	for (int rok = BALANCE_EPOCH_YEAR; rok < BALANCE_EPOCH_YEAR + 800; rok++)		// dny 2^k od BALANCE_EPOCH_YEAR
+	{
+		for (int mesic = 1; mesic <= 12; mesic++)
+		{
+			for (int den = 1; den <= DAYS_IN_MONTH[IsLeapYear(rok)][mesic]; den++)
+			{
+				uint32_t day = DayNumber(rok * 10000 + mesic * 100 + den);
+				if ((day & (day - 1)) == 0)
+					dates.push_back(rok * 10000 + mesic * 100 + den);
+			}
+		}
+	}
 
-	vector<double> inOut;
-	vector<double> amount;
-	vector<string> category;
+	vector<UcetniData> data;
+	auto addRecord = [&data, kategorie](uint32_t datum, BenchRandom &random)
+	{
+		UcetniData zaznam;
+		zaznam.ID = (int)data.size();
+		zaznam.prijemVydaj = (random.Below(2) == 0 ? TYP_PRIJEM : TYP_VYDAJ);
+		zaznam.kategorie = kategorie;
+		zaznam.castka = 1 + random.Below(1000000);
+		zaznam.castkaPlatna = true;
+		zaznam.datum = datum;
+		data.push_back(zaznam);
+	};
+	auto matches = [&data, &random]()
+	{
+		for (int q = 0; q < 2000; q++)
+		{
+			uint32_t datum = (BALANCE_EPOCH_YEAR + random.Below(900)) * 10000 + (1 + random.Below(12)) * 100 + 1 + random.Below(31);
+			int64_t expected = 0;
+			for (const UcetniData &zaznam : data)
+			{
+				if (DayNumber(zaznam.datum) <= DayNumber(datum))
+					expected += (zaznam.prijemVydaj == TYP_PRIJEM ? zaznam.castka : -zaznam.castka);
+			}
+			if (BalanceUntil(datum) != expected)
+				return false;
+		}
+		return true;
+	};
 
-	string htmlPath = (outputHtmlPath.length() != 0 ? outputHtmlPath : defaultOutputHtmlpath);
-	htmlfile.open(htmlPath);
-	htmlfile << "<!DOCTYPE html>\n<html>" << endl;
-	htmlfile << "<head>\n<title>Ucetnictvi</title>\n</head>\n";
-	htmlfile << "<body>\n";
-	htmlfile << "<h1>Domaci ucetnictvi</h1>\n";
+	balanceIndex = BalanceIndex();
+	for (size_t i = 0; i < dates.size() / 2; i++)
+		addRecord(dates[i], random);
+	addRecord(dates.back(), random);
+	UpdateBalanceIndex(data);		// sestaveni najednou
+	bool ok = matches();
 
-	while (data.size() != 0) // data sorting
+	balanceIndex = BalanceIndex();
+	data.clear();
+	addRecord(dates[0], random);
+	UpdateBalanceIndex(data);
+	for (size_t i = 1; i < dates.size(); i++)		// pridavani po jednom, strom se zvetsuje postupne
 	{
-		unsigned int x = 0;
-		unsigned int it = 0;
-		string date1 = data[x].day + TIME_DELIMITER + data[x].month + TIME_DELIMITER + data[x].year;
+		addRecord(dates[i], random);
+		UpdateBalanceIndex(data);
+	}
+	ok = ok && matches();
 
-		if (data[x].ID != -1 && data[x].prijemVydaj != "x" && data[x].kategorie.length() != 0 && SpacedMoneyValue(data[x].castka) != "x" && date1 != ".." && date1 != "::" && date1 != "--")
-		{
-			int m_year = stoi(data[it].year);
-			int m_month = stoi(data[it].month);
-			double m_money = data[it].castka;
+	balanceIndex = BalanceIndex();
+	printf("%-40s %s\n", "zustatky proti prostemu souctu", ok ? "OK" : "CHYBA");
+	return ok;
+}
 
-			for (unsigned int j = 0; j < data.size(); j++)
-			{
-				string date2 = data[j].day + TIME_DELIMITER + data[j].month + TIME_DELIMITER + data[j].year;
-				if (data[j].ID != -1 && data[j].prijemVydaj != "x" && data[x].kategorie.length() != 0 && SpacedMoneyValue(data[j].castka) != "x" && date2 != ".." && date2 != "::" && date2 != "--")
-				{
+/**
+ * @brief Funkce benchmarku: zpracuje argumenty, vygeneruje data a zmeri jednotlive casti programu
+ * @param argc pocet argumentu
+ * @param argv argumenty
+ * @return 0 pokud vse probehlo
+ */
+int BenchmarkMain(int argc, char *argv[])
+{
+	GeneratorMix mix;
+	int firstMix = 2;
+	size_t maxRows = 10000000;
+	bool generateOnly = argc >= 4 && strcmp(argv[1], "--generate") == 0;
+	if (generateOnly)
+		firstMix = 4;
+	else if (argc >= 2)
+		maxRows = strtoull(argv[1], nullptr, 10);
+	int *mixValues[] = { &mix.badDate, &mix.duplicateId, &mix.badMoney, &mix.emptyField };
+	for (int i = 0; i < 4 && firstMix + i < argc; i++)
+		*mixValues[i] = atoi(argv[firstMix + i]);
 
-					if (stoi(data[j].year) > m_year) //&& stoi(data[j].month) > m_month && data[it].castka > m_money
-					{
-						m_year = stoi(data[j].year);
-						m_month = stoi(data[j].month);
-						m_money = data[j].castka;
-						it = j;
-					}
-					else if (stoi(data[j].year) == m_year)
-					{
-						if (stoi(data[j].month) > m_month)
-						{
-							m_year = stoi(data[j].year);
-							m_month = stoi(data[j].month);
-							m_money = data[j].castka;
-							it = j;
-						}
-						else if (stoi(data[j].month) == m_month)
-						{
-							if (data[j].castka > m_money)
-							{
-								m_year = stoi(data[j].year);
-								m_month = stoi(data[j].month);
-								m_money = data[j].castka;
-								it = j;
-							}
-							else if (data[j].castka == m_money)
-							{
-								m_year = stoi(data[j].year);
-								m_month = stoi(data[j].month);
-								m_money = data[j].castka;
-								it = j;
-							}
-						}
-					}
-				}
-				else
-					data.erase(data.begin() + (int)j);
-			}
-			sortedData.push_back(data[it]);
-			data.erase(data.begin() + (int)it);
-		}
-		else
-			data.erase(data.begin() + (int)it);
+	if (argc >= 2 && strcmp(argv[1], "--check") == 0)
+	{
+		bool ok = CheckJournalReplay();
+		ok = CheckLedgerReplay() && ok;
+		ok = CheckBalanceIndex() && ok;
+		return ok ? 0 : 1;
+	}
+	if (generateOnly)
+	{
+		size_t rows = strtoull(argv[2], nullptr, 10);
+		size_t bytes = GenerateCsv(argv[3], rows, mix, 2018);
+		printf("%s: %zu radku, %zu bajtu\n", argv[3], rows, bytes);
+		return bytes != 0 || rows == 0 ? 0 : 1;
 	}
 
-	int lastYear = 0;
+	printf("mix: spatne datum %d %%, duplicitni ID %d %%, spatna castka %d %%, prazdne pole %d %%\n\n",
+		mix.badDate, mix.duplicateId, mix.badMoney, mix.emptyField);
+	printf("%-22s %10s %10s %12s %9s %12s %12s\n", "mereni", "radku", "ms", "radku/s", "MB/s", "alokaci", "alok. bajtu");
 
-	for (unsigned int g = 0; g < sortedData.size(); g++)
+	outputHtmlPath = "benchmark_out.html";
+	for (size_t rows = 1000; rows <= maxRows; rows *= 10)
 	{
-		inOut.push_back(0);
-		inOut.push_back(0);
-		inOut.push_back(0);
-		inOut.push_back(0);
-		category.push_back("koupe");
-		amount.push_back(0);
+		string path = "benchmark_" + to_string(rows) + ".csv";
+		size_t bytes = GenerateCsv(path, rows, mix, 2018 + rows);
+		if (bytes == 0)
+		{
+			printf("Soubor %s nelze vytvorit!\n", path.c_str());
+			return 1;
+		}
+		remove((path + ".snap").c_str());
 
-		int lastMonth = 0;
-		int lstSaveMonth = 0;
-		if (stoi(sortedData[g].year) == lastYear)
-			continue;
-		lastYear = stoi(sortedData[g].year);
-		htmlfile << "<h2>" << sortedData[g].year << "</h2>\n";
+		vector<UcetniData> data;
+		ErrorLog errorLog;
+		IdIndex idIndex;
+		Measure("loadData (parse)", rows, bytes, [&]() { data = loadData(path, errorLog, idIndex); });
+		errorLog = ErrorLog();
+		Measure("loadData (snapshot)", rows, bytes, [&]() { data = loadData(path, errorLog, idIndex); });
+		size_t fileAccepted = CountReportable(data);
 
-		for (unsigned int x = 0; x < sortedData.size(); x++)
+		// stejny pocet radku jako knihy po MAX_ID + 1 radcich, s ID podle souboru se prijmou vsechny platne radky
+		vector<string> ledgerPaths;
+		size_t ledgerBytes = GenerateLedgers("benchmark_" + to_string(rows), rows, mix, 2018 + rows, ledgerPaths);
+		if (ledgerBytes == 0)
 		{
-			bool isHereMonth = false;
-			if (stoi(sortedData[x].month) == lstSaveMonth || stoi(sortedData[x].year) != lastYear)
-				continue;
+			printf("Knihy benchmark_%zu_*.csv nelze vytvorit!\n", rows);
+			return 1;
+		}
+		vector<UcetniData> ledgerData;
+		int oldConflicts = ID_CONFLICTS;
+		ID_CONFLICTS = 1;
+		errorLog = ErrorLog();
+		remove((ledgerPaths[0] + ".journal").c_str());
+		Measure("LoadLedgers", rows, ledgerBytes, [&]() { ledgerData = LoadLedgers(ledgerPaths, errorLog, idIndex); });
+		ID_CONFLICTS = oldConflicts;
+		for (const string &ledgerPath : ledgerPaths)
+			remove(ledgerPath.c_str());
+		size_t ledgerAccepted = CountReportable(ledgerData);
+		printf("prijato zaznamu z %zu radku: loadData %zu, LoadLedgers (knih: %zu) %zu\n", rows, fileAccepted, ledgerPaths.size(), ledgerAccepted);
+
+		// pole pro jednotlive kontroly, stejna data jako v souboru
+		MappedFile file;
+		MapFile(path, file);
+		vector<string_view> dates, amounts, fields;
+		const char *position = file.data;
+		while (position < file.data + file.size)
+		{
+			SplitCsvFields(NextCsvLine(position, file.data + file.size), fields);
+			amounts.push_back(fields[3]);
+			dates.push_back(fields[4]);
+		}
 
-			lastMonth = stoi(sortedData[x].month);
+		size_t fieldCount = 0;
+		Measure("SplitCsvFields", rows, file.size, [&]()
+		{
+			const char *position = file.data;
+			while (position < file.data + file.size)
+			{
+				SplitCsvFields(NextCsvLine(position, file.data + file.size), fields);
+				fieldCount += fields.size();
+			}
+		});
+		Measure("NextCsvRecord", rows, file.size, [&]()
+		{
+			CsvScanner scanner;
+			CsvScannerInit(scanner, file.data, file.data + file.size);
+			while (scanner.position < scanner.end)
+			{
+				NextCsvRecord(scanner, fields);
+				fieldCount += fields.size();
+			}
+		});
 
-			for (unsigned int k = 0; k < sortedData.size(); k++)
+		vector<UcetniData> values(1);
+		errorLog = ErrorLog();
+		Measure("TimeFormat", dates.size(), 0, [&]()
+		{
+			for (string_view date : dates)
+				TimeFormat(date, 0, errorLog, 0, values);
+		});
+		errorLog = ErrorLog();
+		int64_t sum = 0;
+		Measure("CheckMoney", amounts.size(), 0, [&]()
+		{
+			int64_t castka = 0;
+			for (string_view amount : amounts)
 			{
-				if (stoi(sortedData[k].month) == lastMonth && stoi(sortedData[k].year) == lastYear)
-				{
-					isHereMonth = true;
-					break;
-				}
+				if (CheckMoney(amount, errorLog, 0, castka))
+					sum += castka;
 			}
+		});
+		UnmapFile(file);
+
+		size_t length = 0;
+		Measure("SpacedMoneyValue", ledgerData.size(), 0, [&]()
+		{
+			MoneyBuffer money;
+			for (const UcetniData &zaznam : ledgerData)
+				length += SpacedMoneyValue(zaznam.castka, money).size();
+		});
 
-			if(isHereMonth)
+		// CreateHtml nad zaznamy z knih, pocet radku je pocet prijatych zaznamu
+		htmlCache = HtmlCache();
+		Measure("CreateHtml", ledgerAccepted, 0, [&]() { CreateHtml(ledgerData); });
+		for (size_t i = ledgerData.size(); i-- > 0; )
+		{
+			if (IsReportable(ledgerData[i]))
 			{
-				//auto it = max_element(begin(data), end(data));
-				int srtMonth = stoi(sortedData[x].month);
-				if (sortedData[x].month.length() == 2 && sortedData[x].month[0] == 0)
-					srtMonth = int(sortedData[x].month[1]);
-
-				htmlfile << "<h3><i><b>" << string(mnt.nazvyMesicu[srtMonth - 1]) << "</b></i></h3>" << endl;
-				htmlfile << "<p>Serazeno dle nejvyssi castky</p>";
-				htmlfile << "<table border = \"1\">\n";
-				htmlfile << "	<tr>\n";
-				htmlfile << "		<th>ID</th>\n";
-				htmlfile << "		<th>Typ</th>\n";
-				htmlfile << "		<th>Kategorie</th>\n";
-				htmlfile << "		<th>Castka [Kc]</th>\n";
-				htmlfile << "		<th>Datum</th>\n";
-				htmlfile << "	</tr>" << endl;
-
-				for (unsigned int i = 0; i < sortedData.size(); i++)
-				{
-					if (stoi(sortedData[i].month) == lastMonth && stoi(sortedData[i].year) == lastYear)
-					{
-						string date = sortedData[i].day + TIME_DELIMITER + sortedData[i].month + TIME_DELIMITER + sortedData[i].year;
-						htmlfile << "	<tr>\n";
-						htmlfile << "		<td>" << sortedData[i].ID << "</td>\n";
-						htmlfile << "		<td>" << sortedData[i].prijemVydaj << "</td>\n";
-						htmlfile << "		<td>" << sortedData[i].kategorie << "</td>\n";
-						htmlfile << "		<td>" << SpacedMoneyValue(sortedData[i].castka) << "</td>\n";
-						htmlfile << "		<td>" << date << "</td>\n";
-						htmlfile << "	</tr>\n";
-
-						if (sortedData[i].prijemVydaj == "prijem")
-						{
-							inOut[0] += sortedData[i].castka;
-							inOut[2] += sortedData[i].castka;
-						}
-						else
-						{
-							inOut[1] += sortedData[i].castka;
-							inOut[3] += sortedData[i].castka;
-						}
-
-						unsigned int l;
-						for (l = 0; l < category.size(); l++)
-						{
-							if (category[l] == sortedData[i].kategorie)
-							{
-								amount[l] += sortedData[i].castka;
-								break;
-							}
-						}
-						if (l >= category.size())
-						{
-							category.push_back(sortedData[i].kategorie);
-							amount.push_back(sortedData[i].castka);
-						}
-					}
-				}
-				htmlfile << "</table>\n" << endl;
-				htmlfile << "<p><b>Celkem za mesic</b></p>";
-				htmlfile << "<table border = \"1\">\n";
-				htmlfile << "	<tr>\n";
-				for (unsigned int l = 0; l < category.size(); l++)
-				{
-					if(amount[l] != 0)
-						htmlfile << "		<th>" << category[l] << "</th>\n";
-				}
-				htmlfile << "	</tr>" << endl;
-				htmlfile << "	<tr>\n";
-				for (unsigned int l = 0; l < category.size(); l++)
-				{
-					if (amount[l] != 0)
-						htmlfile << "		<td>" << SpacedMoneyValue(amount[l]) << "</td>\n";
-				}
-				htmlfile << "	</tr>\n";
-				htmlfile << "</table>" << endl;
-				htmlfile << "<br>\n";
-				htmlfile << "<table border = \"1\">\n";
-				htmlfile << "	<tr>\n";
-				htmlfile << "		<th>Prijem</th>\n";
-				htmlfile << "		<th>Vydaj</th>\n";
-				htmlfile << "		<th>Celkem</th>\n";
-				htmlfile << "	</tr>" << endl;
-				htmlfile << "	<tr>\n";
-				htmlfile << "		<td>" << SpacedMoneyValue(inOut[0]) << "</td>\n";
-				htmlfile << "		<td>" << SpacedMoneyValue(inOut[1]) << "</td>\n";
-				htmlfile << "		<td>" << SpacedMoneyValue(inOut[0] - inOut[1]) << "</td>\n";
-				htmlfile << "	</tr>\n";
-				htmlfile << "</table>" << endl;
-
-				lstSaveMonth = lastMonth;
+				ledgerData[i].castka++;		// zmena jednoho mesice
+				break;
 			}
-			lastMonth = lstSaveMonth;
-			inOut[0] = 0;
-			inOut[1] = 0;
 		}
+		Measure("CreateHtml (1 mesic)", ledgerAccepted, 0, [&]() { CreateHtml(ledgerData); });
+		printf("kontrolni soucty: %lld %zu %zu\n\n", (long long)sum, length, fieldCount);		// aby prekladac merene smycky nevynechal
 
-		htmlfile << "<p><b>Celkem za rok</b></p>";
-		//htmlfile << "<br>\n";
-		htmlfile << "<table border = \"1\">\n";
-		htmlfile << "	<tr>\n";
-		htmlfile << "		<th>Prijem</th>\n";
-		htmlfile << "		<th>Vydaj</th>\n";
-		htmlfile << "		<th>Celkem</th>\n";
-		htmlfile << "	</tr>" << endl;
-		htmlfile << "	<tr>\n";
-		htmlfile << "		<td>" << SpacedMoneyValue(inOut[2]) << "</td>\n";
-		htmlfile << "		<td>" << SpacedMoneyValue(inOut[3]) << "</td>\n";
-		htmlfile << "		<td>" << SpacedMoneyValue(inOut[2] - inOut[3]) << "</td>\n";
-		htmlfile << "	</tr>\n";
-		htmlfile << "</table>" << endl;
-
-		inOut.clear();
-		amount.clear();
-		category.clear();
+		remove(path.c_str());
+		remove((path + ".snap").c_str());
 	}
-
-	//ending html
-	htmlfile << "</tbody>\n";
-	htmlfile << "</body>\n</html>";
-	htmlfile.close();
+	remove(outputHtmlPath.c_str());
+	return 0;
 }
+#endif